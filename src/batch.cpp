@@ -0,0 +1,233 @@
+#include "batch.hpp"
+
+#include "capture.hpp"
+#include "comparison.hpp"
+#include "utils.hpp"
+
+#include <glob.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <iomanip>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Text, line table and frame model together come to a few times the size of a verbose tshark dump
+const size_t working_set_factor = 4;
+
+size_t file_size(const std::string& filename) {
+  struct stat st{};
+  return stat(filename.c_str(), &st) == 0 ? static_cast<size_t>(st.st_size) : 0;
+}
+
+// Hands out shares of the memory budget, blocking until a share fits
+class memory_budget {
+public:
+
+  explicit memory_budget(size_t total) : total_(total) {}
+
+  size_t acquire(size_t amount) {
+    if (total_ == 0) {
+      return 0;
+    }
+    amount = std::min(amount, total_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&]() { return used_ + amount <= total_; });
+    used_ += amount;
+    return amount;
+  }
+
+  void release(size_t amount) {
+    if (amount == 0) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      used_ -= amount;
+    }
+    cv_.notify_all();
+  }
+
+private:
+
+  size_t total_;
+  size_t used_{0};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+};
+
+void analyze_capture(const std::string& filename, const batch_options& opts, batch_result& result) {
+  result.filename = filename;
+  auto start = std::chrono::steady_clock::now();
+  try {
+    frame_filter filter;
+    filter.domain = opts.domain;
+    capture cap;
+    if (!load_capture(filename, cap, false, filter)) {
+      result.error = "unable to open input file";
+    } else if (cap.frame_count == 0) {
+      result.error = "no frames found (not a tshark verbose text dump?)";
+    } else {
+      filter_capture_domain(cap, filter);
+      run_summary rs;
+      gather_run_summary(cap, opts.domain, opts.frag_table_size, rs);
+      result.frame_count = rs.frame_count;
+      result.rtps_frame_count = rs.rtps_frame_count;
+      result.rtps_bytes = rs.rtps_bytes;
+      result.participant_count = rs.participant_roles.size();
+      result.endpoint_count = rs.endpoint_keys.size();
+      result.conversation_count = rs.conversation_discovery_times.size();
+      result.discovery_times = rs.discovery_times;
+      result.user_discovery_times = rs.user_discovery_times;
+      result.ip_fragment_times = rs.ifs.reconstruction_times;
+      result.rtps_fragment_times = rs.rfs.reassembly_times;
+      result.ok = true;
+    }
+  } catch (const std::exception& e) {
+    result.error = e.what();
+  } catch (...) {
+    result.error = "unknown error";
+  }
+  result.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void write_json_string(std::ostream& os, const std::string& value) {
+  os << '"';
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        os << "\\\"";
+        break;
+      case '\\':
+        os << "\\\\";
+        break;
+      case '\n':
+        os << "\\n";
+        break;
+      case '\t':
+        os << "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<unsigned>(c) << std::dec << std::setfill(' ');
+        } else {
+          os << c;
+        }
+    }
+  }
+  os << '"';
+}
+
+void write_json_histogram(std::ostream& os, const hdr_histogram& h) {
+  os << "{\"count\": " << h.count() << ", \"min\": " << h.min() << ", \"mean\": " << h.mean() << ", \"p50\": " << h.percentile(50.0)
+     << ", \"p90\": " << h.percentile(90.0) << ", \"p99\": " << h.percentile(99.0) << ", \"max\": " << h.max() << "}";
+}
+
+}
+
+string_vec list_batch_captures(const std::string& dir) {
+  string_vec result;
+  glob_t matches;
+  if (glob((dir + "/*").c_str(), 0, nullptr, &matches) == 0) {
+    for (size_t i = 0; i < matches.gl_pathc; ++i) {
+      struct stat st{};
+      if (stat(matches.gl_pathv[i], &st) == 0 && S_ISREG(st.st_mode)) {
+        result.emplace_back(matches.gl_pathv[i]);
+      }
+    }
+  }
+  globfree(&matches);
+  return result;
+}
+
+void run_batch(const string_vec& filenames, const batch_options& opts, std::vector<batch_result>& results) {
+  results.clear();
+  results.resize(filenames.size());
+  memory_budget budget(opts.memory_budget);
+  std::atomic<size_t> next{0};
+  std::vector<std::thread> workers;
+  size_t jobs = std::max<size_t>(1, std::min(opts.jobs, filenames.size()));
+  for (size_t w = 0; w < jobs; ++w) {
+    workers.emplace_back([&]() {
+      for (size_t i = next++; i < filenames.size(); i = next++) {
+        size_t share = budget.acquire(file_size(filenames[i]) * working_set_factor);
+        analyze_capture(filenames[i], opts, results[i]);
+        budget.release(share);
+      }
+    });
+  }
+  for (auto & worker : workers) {
+    worker.join();
+  }
+}
+
+void write_batch_json(std::ostream& os, const std::vector<batch_result>& results, size_t worst_count) {
+  hdr_histogram discovery_times;
+  hdr_histogram user_discovery_times;
+  hdr_histogram ip_fragment_times;
+  hdr_histogram rtps_fragment_times;
+  size_t failed = 0;
+  std::vector<const batch_result*> ranked;
+  for (const auto & r : results) {
+    if (!r.ok) {
+      ++failed;
+      continue;
+    }
+    discovery_times.merge(r.discovery_times);
+    user_discovery_times.merge(r.user_discovery_times);
+    ip_fragment_times.merge(r.ip_fragment_times);
+    rtps_fragment_times.merge(r.rtps_fragment_times);
+    ranked.push_back(&r);
+  }
+  std::stable_sort(ranked.begin(), ranked.end(), [](const batch_result* a, const batch_result* b) {
+    return a->user_discovery_times.percentile(99.0) > b->user_discovery_times.percentile(99.0);
+  });
+
+  os << std::fixed << std::setprecision(6);
+  os << "{\n  \"captures\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const batch_result& r = results[i];
+    os << (i == 0 ? "\n" : ",\n") << "    {\"file\": ";
+    write_json_string(os, r.filename);
+    os << ", \"status\": \"" << (r.ok ? "ok" : "error") << "\", \"elapsed_seconds\": " << r.elapsed;
+    if (!r.ok) {
+      os << ", \"error\": ";
+      write_json_string(os, r.error);
+      os << "}";
+      continue;
+    }
+    os << ", \"frames\": " << r.frame_count << ", \"rtps_frames\": " << r.rtps_frame_count << ", \"rtps_bytes\": " << r.rtps_bytes
+       << ", \"participants\": " << r.participant_count << ", \"endpoints\": " << r.endpoint_count << ", \"conversations\": " << r.conversation_count;
+    os << ",\n     \"discovery_time\": ";
+    write_json_histogram(os, r.discovery_times);
+    os << ",\n     \"user_discovery_time\": ";
+    write_json_histogram(os, r.user_discovery_times);
+    os << ",\n     \"ip_fragment_reconstruction_time\": ";
+    write_json_histogram(os, r.ip_fragment_times);
+    os << ",\n     \"rtps_fragment_reassembly_time\": ";
+    write_json_histogram(os, r.rtps_fragment_times);
+    os << "}";
+  }
+  os << "\n  ],\n  \"fleet\": {\n    \"capture_count\": " << results.size() << ",\n    \"failed_count\": " << failed;
+  os << ",\n    \"discovery_time\": ";
+  write_json_histogram(os, discovery_times);
+  os << ",\n    \"user_discovery_time\": ";
+  write_json_histogram(os, user_discovery_times);
+  os << ",\n    \"ip_fragment_reconstruction_time\": ";
+  write_json_histogram(os, ip_fragment_times);
+  os << ",\n    \"rtps_fragment_reassembly_time\": ";
+  write_json_histogram(os, rtps_fragment_times);
+  os << ",\n    \"worst_runs\": [";
+  for (size_t i = 0; i < ranked.size() && i < worst_count; ++i) {
+    os << (i == 0 ? "\n" : ",\n") << "      {\"file\": ";
+    write_json_string(os, ranked[i]->filename);
+    os << ", \"user_discovery_p99\": " << ranked[i]->user_discovery_times.percentile(99.0) << ", \"user_discovery_max\": " << ranked[i]->user_discovery_times.max() << "}";
+  }
+  os << "\n    ]\n  }\n}\n" << std::flush;
+}
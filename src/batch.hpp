@@ -0,0 +1,45 @@
+#pragma once
+
+#include "common_types.hpp"
+#include "hdr_histogram.hpp"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct batch_options {
+  size_t jobs{1};
+  size_t memory_budget{0}; // bytes of estimated working set across concurrent captures, 0 for unlimited
+  uint16_t domain{0xFF};
+  size_t frag_table_size{65536};
+  size_t worst_count{10};
+};
+
+// Condensed result of one capture; the frame and endpoint models are dropped as soon as these are filled in
+struct batch_result {
+  std::string filename;
+  bool ok{false};
+  std::string error;
+  double elapsed{0.0};
+  size_t frame_count{0};
+  size_t rtps_frame_count{0};
+  size_t rtps_bytes{0};
+  size_t participant_count{0};
+  size_t endpoint_count{0};
+  size_t conversation_count{0};
+  hdr_histogram discovery_times;
+  hdr_histogram user_discovery_times;
+  hdr_histogram ip_fragment_times;
+  hdr_histogram rtps_fragment_times;
+};
+
+// Regular files directly inside dir, sorted by name
+string_vec list_batch_captures(const std::string& dir);
+
+// Analyzes the captures on a pool of opts.jobs threads. A capture is only started once its estimated working set fits
+// in what's left of the memory budget (a capture too big for the whole budget runs on its own). Failures are recorded
+// in the capture's result and never stop the batch.
+void run_batch(const string_vec& filenames, const batch_options& opts, std::vector<batch_result>& results);
+
+// One JSON document with a summary per capture and fleet-level aggregates (merged histograms, worst runs)
+void write_batch_json(std::ostream& os, const std::vector<batch_result>& results, size_t worst_count);
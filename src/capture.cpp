@@ -0,0 +1,308 @@
+#include "capture.hpp"
+
+#include "endpoint_info.hpp"
+#include "line_scanner.hpp"
+
+#include <glob.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+// Protocols that rule out RTPS in the same frame; link layers and encapsulations aren't listed, so unfamiliar ones
+// (VLAN tags, loopback, cooked or raw captures) are kept and left to the parser
+bool is_non_rtps_protocol_line(const std::string& line) {
+  return line.compare(0, 27, "Address Resolution Protocol") == 0 || line.compare(0, 29, "Transmission Control Protocol") == 0 ||
+    line.compare(0, 33, "Internet Control Message Protocol") == 0;
+}
+
+bool is_nonzero_fragment_offset(const std::string& line) {
+  size_t fpos;
+  if ((fpos = line.find("Fragment offset: ")) == std::string::npos && (fpos = line.find("Fragment Offset: ")) == std::string::npos) {
+    return false;
+  }
+  std::stringstream ss(line.substr(fpos + 17));
+  size_t frag_off = 0;
+  ss >> frag_off;
+  return frag_off != 0;
+}
+
+const size_t read_chunk_size = 4 << 20;
+
+struct merge_entry {
+  double epoch_time;
+  size_t file_index;
+  size_t frame_no;
+};
+
+}
+
+bool load_capture(const std::string& filename, capture& cap, bool keep_text, const frame_filter& filter) {
+  cap.filename = filename;
+
+  std::ifstream ifs(filename.c_str(), std::ios::binary);
+  if (!ifs.good()) {
+    std::cout << "Unable to open input file " << filename << std::endl;
+    return false;
+  }
+
+  // Frames are classified by their top-level (unindented) protocol lines as they stream past, so the lines of frames
+  // positively identified as not RTPS are never stored; IP fragments are kept since they may complete an RTPS datagram
+  size_t frame_no = 0;
+  string_vec* frame_lines = nullptr;
+  bool skipping = false;
+  bool seen_udp = false;
+  bool decided = false;
+  bool ip_fragment = false;
+  auto add_line = [&](const char* start, const line_entry& entry) {
+    if (entry.kind == LK_FRAME_HEADER) {
+      frame_no = static_cast<size_t>(std::strtoull(start + 6, nullptr, 10));
+      ++cap.frame_count;
+      skipping = seen_udp = decided = ip_fragment = false;
+      frame_lines = &cap.tfm[frame_no];
+    } else if (skipping) {
+      return;
+    } else if (frame_lines == nullptr) {
+      frame_lines = &cap.tfm[frame_no];
+    }
+    frame_lines->emplace_back(start, entry.length);
+    const std::string& line = frame_lines->back();
+
+    if (!decided && entry.kind == LK_SECTION) {
+      if (line.compare(0, 41, "Real-Time Publish-Subscribe Wire Protocol") == 0) {
+        decided = true;
+      } else if (line.compare(0, 22, "User Datagram Protocol") == 0) {
+        seen_udp = true;
+      } else if (seen_udp || is_non_rtps_protocol_line(line)) {
+        // A UDP payload other than RTPS, or a protocol that can't carry it, is only worth keeping as the payload of an IP fragment
+        decided = ip_fragment && !seen_udp;
+        skipping = !decided;
+      }
+      if (skipping) {
+        ++cap.non_rtps_frame_count;
+        cap.tfm.erase(frame_no);
+        frame_lines = nullptr;
+      }
+    } else if (!decided && !seen_udp && !ip_fragment && entry.kind == LK_NESTED && (line.find("More fragments: Set") != std::string::npos || is_nonzero_fragment_offset(line))) {
+      ip_fragment = true;
+    }
+  };
+
+  // The file is scanned a chunk at a time, so only the lines that are kept are ever held in full; a partial last line
+  // is carried over into the next chunk
+  std::string text;
+  std::vector<char> buffer(read_chunk_size);
+  line_table lines;
+  bool done = false;
+  while (!done) {
+    ifs.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    done = ifs.gcount() == 0;
+    text.append(buffer.data(), static_cast<size_t>(ifs.gcount()));
+    size_t complete = text.size();
+    if (!done) {
+      size_t last_newline = text.rfind('\n');
+      if (last_newline == std::string::npos) {
+        continue;
+      }
+      complete = last_newline + 1;
+    }
+    lines.clear();
+    scan_lines(text.data(), complete, lines);
+    for (const auto & entry : lines) {
+      add_line(text.data() + entry.offset, entry);
+    }
+    text.erase(0, complete);
+  }
+
+  cap.filtered_frame_count = process_frame_data(cap.tfm, cap.frames, cap.ift, filter);
+  finish_ip_fragments(cap.ift);
+
+  if (!keep_text) {
+    tshark_frame_map().swap(cap.tfm);
+  }
+  return true;
+}
+
+bool load_captures(const string_vec& filenames, std::vector<capture>& caps, bool keep_text, const frame_filter& filter, size_t jobs) {
+  caps.resize(filenames.size());
+  std::vector<char> loaded(filenames.size(), 0);
+  std::atomic<size_t> next{0};
+  std::vector<std::thread> workers;
+  size_t worker_count = std::max<size_t>(1, std::min(jobs, filenames.size()));
+  for (size_t w = 0; w < worker_count; ++w) {
+    workers.emplace_back([&]() {
+      for (size_t i = next++; i < filenames.size(); i = next++) {
+        try {
+          loaded[i] = load_capture(filenames[i], caps[i], keep_text, filter) ? 1 : 0;
+        } catch (...) {
+          // Most likely out of memory; whatever was loaded of this file is dropped so the others can continue
+          caps[i] = capture();
+          std::cout << "Unable to load input file " << filenames[i] << std::endl;
+        }
+      }
+    });
+  }
+  bool result = true;
+  for (auto & worker : workers) {
+    worker.join();
+  }
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    result &= (loaded[i] != 0);
+  }
+  return result;
+}
+
+string_vec expand_capture_patterns(const string_vec& patterns) {
+  string_vec result;
+  for (const auto & pattern : patterns) {
+    glob_t matches;
+    if (glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+      for (size_t i = 0; i < matches.gl_pathc; ++i) {
+        result.emplace_back(matches.gl_pathv[i]);
+      }
+    } else {
+      result.push_back(pattern);
+    }
+    globfree(&matches);
+  }
+  return result;
+}
+
+void merge_captures(std::vector<capture>& caps, capture& merged) {
+  merged.filename.clear();
+  merged.source_files.clear();
+  merged.frame_sources.assign(1, frame_source{0, 0});
+  merged.frame_count = 0;
+  merged.non_rtps_frame_count = 0;
+  merged.filtered_frame_count = 0;
+
+  // Reference times are relative to the start of each file, so each file's epoch base converts them back to epoch times
+  std::vector<double> epoch_base(caps.size(), 0.0);
+  double first_epoch = std::numeric_limits<double>::infinity();
+  std::vector<merge_entry> entries;
+  for (size_t i = 0; i < caps.size(); ++i) {
+    capture& cap = caps[i];
+    merged.filename += (i == 0 ? "" : ", ") + cap.filename;
+    merged.source_files.push_back(cap.filename);
+    merged.frame_count += cap.frame_count;
+    merged.non_rtps_frame_count += cap.non_rtps_frame_count;
+    merged.filtered_frame_count += cap.filtered_frame_count;
+    if (!cap.frames.empty()) {
+      const rtps_frame& front = cap.frames.begin()->second;
+      epoch_base[i] = front.frame_epoch_time - front.frame_reference_time;
+    }
+
+    // Frames that didn't parse as RTPS still need a place in the merged numbering (their text or IP fragments may be referenced)
+    std::set<size_t> numbers;
+    std::unordered_map<size_t, double> fragment_times;
+    for (const auto & it : cap.tfm) {
+      numbers.insert(it.first);
+    }
+    for (const auto & it : cap.frames) {
+      numbers.insert(it.first);
+    }
+    for (const auto & dg : cap.ift.finished) {
+      numbers.insert(dg.first_frame);
+      numbers.insert(dg.last_frame);
+      fragment_times[dg.first_frame] = epoch_base[i] + dg.first_time;
+      fragment_times[dg.last_frame] = epoch_base[i] + dg.last_time;
+    }
+
+    double last_time = epoch_base[i];
+    for (size_t frame_no : numbers) {
+      auto fit = cap.frames.find(frame_no);
+      auto ftit = fragment_times.find(frame_no);
+      if (fit != cap.frames.end()) {
+        last_time = fit->second.frame_epoch_time;
+      } else if (ftit != fragment_times.end()) {
+        last_time = ftit->second;
+      }
+      entries.push_back(merge_entry{last_time, i, frame_no});
+      first_epoch = std::min(first_epoch, last_time);
+    }
+  }
+
+  // Entries are grouped by file in frame order, so a stable sort keeps ties in file order and each file's frames in their original order
+  std::stable_sort(entries.begin(), entries.end(), [](const merge_entry& a, const merge_entry& b) { return a.epoch_time < b.epoch_time; });
+
+  std::vector<std::unordered_map<size_t, size_t>> renumber(caps.size());
+  for (const auto & entry : entries) {
+    renumber[entry.file_index][entry.frame_no] = merged.frame_sources.size();
+    merged.frame_sources.push_back(frame_source{entry.file_index, entry.frame_no});
+  }
+
+  for (size_t i = 0; i < caps.size(); ++i) {
+    capture& cap = caps[i];
+    const auto& numbers = renumber[i];
+    for (auto & it : cap.frames) {
+      size_t frame_no = numbers.at(it.first);
+      rtps_frame& frame = merged.frames[frame_no];
+      frame = std::move(it.second);
+      frame.frame_no = frame_no;
+      frame.frame_reference_time = frame.frame_epoch_time - first_epoch;
+    }
+    for (auto & it : cap.tfm) {
+      merged.tfm[numbers.at(it.first)] = std::move(it.second);
+    }
+    for (auto & dg : cap.ift.finished) {
+      dg.first_frame = numbers.at(dg.first_frame);
+      dg.last_frame = numbers.at(dg.last_frame);
+      dg.first_time += epoch_base[i] - first_epoch;
+      dg.last_time += epoch_base[i] - first_epoch;
+      merged.ift.finished.push_back(std::move(dg));
+    }
+  }
+  std::sort(merged.ift.finished.begin(), merged.ift.finished.end(), [](const ip_datagram& a, const ip_datagram& b) { return a.first_frame < b.first_frame; });
+  caps.clear();
+}
+
+void filter_capture_times(capture& cap, const frame_filter& filter) {
+  for (auto it = cap.frames.begin(); it != cap.frames.end();) {
+    if (filter_accepts_time(filter, it->second)) {
+      ++it;
+    } else {
+      it = cap.frames.erase(it);
+      ++cap.filtered_frame_count;
+    }
+  }
+}
+
+void filter_capture_domain(capture& cap, const frame_filter& filter) {
+  if (filter.domain == 0xFF) {
+    return;
+  }
+  endpoint_map participants;
+  gather_participant_info(cap.frames, participants);
+  std::unordered_set<std::string> domain_prefixes;
+  for (const auto & it : participants) {
+    if (it.second.domain_id == filter.domain) {
+      domain_prefixes.insert(it.first.substr(0, 24));
+    }
+  }
+  for (auto it = cap.frames.begin(); it != cap.frames.end();) {
+    if (domain_prefixes.count(it->second.guid_prefix) != 0u) {
+      ++it;
+    } else {
+      it = cap.frames.erase(it);
+      ++cap.filtered_frame_count;
+    }
+  }
+}
+
+std::string describe_frame_source(const capture& cap, size_t frame_no) {
+  if (frame_no == 0 || frame_no >= cap.frame_sources.size()) {
+    return std::string();
+  }
+  const frame_source& source = cap.frame_sources[frame_no];
+  return cap.source_files[source.file_index] + " frame " + std::to_string(source.frame_no);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "common_types.hpp"
+#include "frames.hpp"
+#include "ip_fragments.hpp"
+#include "tshark_parsing.hpp"
+
+#include <string>
+#include <vector>
+
+struct frame_source {
+  size_t file_index;
+  size_t frame_no;
+};
+
+struct capture {
+  std::string filename;
+  tshark_frame_map tfm;
+  rtps_frame_map frames;
+  ip_fragment_tracker ift;
+  size_t frame_count{0}; // every frame in the input, including skipped ones
+  size_t non_rtps_frame_count{0}; // frames skipped while reading because their protocol stack can't carry RTPS
+  size_t filtered_frame_count{0}; // frames rejected by the frame filter before submessage parsing
+  // Only filled in for merged captures: the input files and, indexed by merged frame number, where each frame came from
+  string_vec source_files;
+  std::vector<frame_source> frame_sources;
+};
+
+// Reads a tshark verbose text dump and parses the frames accepted by filter; the raw text is only retained when keep_text is set
+bool load_capture(const std::string& filename, capture& cap, bool keep_text, const frame_filter& filter);
+
+// Loads the files on a pool of up to jobs threads; caps is resized to match filenames and false is returned if any file couldn't be loaded
+bool load_captures(const string_vec& filenames, std::vector<capture>& caps, bool keep_text, const frame_filter& filter, size_t jobs);
+
+// Expands shell-style wildcards in each pattern (sorted per pattern); patterns that match nothing are kept as-is
+string_vec expand_capture_patterns(const string_vec& patterns);
+
+// Interleaves the frames of several captures by epoch time into merged, renumbering frames from 1 and rebasing
+// frame_reference_time (and IP datagram times) on the earliest frame; caps are consumed in the process
+void merge_captures(std::vector<capture>& caps, capture& merged);
+
+// Drops parsed frames outside the filter's time window (counting them as filtered); for merged captures, whose frame
+// times only share an origin once merged
+void filter_capture_times(capture& cap, const frame_filter& filter);
+
+// Keeps only frames sent by participants whose SPDP announcements put them in filter.domain (the endpoint domain used by
+// the analysis). Runs after parsing: before the participants are known, only multicast to well-known ports says anything
+// reliable about the domain, since tshark derives the RTPS header's domain from the (possibly ephemeral) UDP port.
+void filter_capture_domain(capture& cap, const frame_filter& filter);
+
+// Describes where a frame of a merged capture originally came from (empty for captures loaded from a single file)
+std::string describe_frame_source(const capture& cap, size_t frame_no);
@@ -1,7 +1,21 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
 using string_vec = std::vector<std::string>;
 
+// A contiguous run of lines within a string_vec (such as one protocol section of a frame), viewed without copying
+struct line_range {
+  string_vec::const_iterator first;
+  string_vec::const_iterator last;
+
+  string_vec::const_iterator begin() const { return first; }
+  string_vec::const_iterator end() const { return last; }
+  bool empty() const { return first == last; }
+  size_t size() const { return static_cast<size_t>(last - first); }
+  const std::string& front() const { return *first; }
+  const std::string& operator[](size_t i) const { return first[static_cast<std::ptrdiff_t>(i)]; }
+};
+
@@ -0,0 +1,227 @@
+#include "comparison.hpp"
+
+#include "utils.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <set>
+
+namespace {
+
+const size_t guid_prefix_length = 24;
+
+void assign_roles(run_summary& rs) {
+  for (const auto & it : rs.em) {
+    const endpoint_info& info = it.second;
+    if (info.guid.length() == 32 && info.guid.compare(guid_prefix_length, std::string::npos, "000100c2") == 0) {
+      rs.participant_roles[info.guid.substr(0, guid_prefix_length)] = info.src_net.ip + ":" + info.src_net.port;
+    }
+  }
+
+  // Endpoints of one role on one topic are told apart by their order of entity ids, which creation order determines
+  std::map<std::string, size_t> ordinals;
+  for (const auto & it : rs.em) {
+    const endpoint_info& info = it.second;
+    if (info.guid.length() != 32) {
+      continue;
+    }
+    auto rit = rs.participant_roles.find(info.guid.substr(0, guid_prefix_length));
+    std::string role = rit == rs.participant_roles.end() ? info.guid.substr(0, guid_prefix_length) : rit->second;
+    std::string key;
+    if (is_guid_builtin(info.guid) || info.topic_id == NO_TOPIC) {
+      key = role + "/" + info.guid.substr(guid_prefix_length);
+    } else {
+      bool writer = info.guid.back() == '2' || info.guid.back() == '3';
+      key = role + "/" + rs.topics.topics[info.topic_id].name + (writer ? "/writer" : "/reader");
+      key += "#" + std::to_string(ordinals[key]++);
+    }
+    rs.endpoint_keys[info.guid] = key;
+  }
+}
+
+std::string endpoint_key(const run_summary& rs, const std::string& guid) {
+  auto it = rs.endpoint_keys.find(guid);
+  return it == rs.endpoint_keys.end() ? guid : it->second;
+}
+
+void print_delta(std::ostream& os, const std::string& label, double a, double b) {
+  os << "   - " << std::left << std::setw(12) << label << std::right << std::fixed << std::setprecision(6)
+     << std::setw(14) << a << " -> " << std::setw(14) << b << " (" << std::showpos << b - a << std::noshowpos << ")" << std::endl;
+}
+
+void print_count_delta(std::ostream& os, const std::string& label, size_t a, size_t b) {
+  os << " - " << label << ": " << a << " -> " << b << " (" << std::showpos << static_cast<long long>(b) - static_cast<long long>(a) << std::noshowpos << ")" << std::endl;
+}
+
+void print_histogram_deltas(std::ostream& os, const std::string& title, const hdr_histogram& a, const hdr_histogram& b) {
+  os << " - " << title << " (count " << a.count() << " -> " << b.count() << "):" << std::endl;
+  print_delta(os, "P50", a.percentile(50.0), b.percentile(50.0));
+  print_delta(os, "P90", a.percentile(90.0), b.percentile(90.0));
+  print_delta(os, "P99", a.percentile(99.0), b.percentile(99.0));
+  print_delta(os, "Max", a.max(), b.max());
+}
+
+template <typename V>
+void count_alignment(const std::map<std::string, V>& a, const std::map<std::string, V>& b, size_t& both, size_t& only_a, size_t& only_b) {
+  both = only_a = only_b = 0;
+  auto ait = a.begin();
+  auto bit = b.begin();
+  while (ait != a.end() || bit != b.end()) {
+    if (bit == b.end() || (ait != a.end() && ait->first < bit->first)) {
+      ++only_a;
+      ++ait;
+    } else if (ait == a.end() || bit->first < ait->first) {
+      ++only_b;
+      ++bit;
+    } else {
+      ++both;
+      ++ait;
+      ++bit;
+    }
+  }
+}
+
+}
+
+void gather_run_summary(const capture& cap, uint16_t domain, size_t frag_table_size, run_summary& rs) {
+  const rtps_frame_map& frames = cap.frames;
+  rs.filename = cap.filename;
+  rs.frame_count = cap.frame_count;
+  rs.rtps_frame_count = frames.size();
+  for (const auto & it : frames) {
+    rs.rtps_bytes += it.second.udp_length;
+  }
+
+  gather_participant_info(frames, rs.em);
+  gather_endpoint_info(frames, rs.em);
+  gather_endpoint_lifecycle(frames, rs.em);
+  gather_topic_index(rs.em, rs.topics);
+  gather_conversation_info(frames, rs.em, rs.cm);
+  gather_conversation_lifecycle(rs.em, rs.cm);
+  assign_roles(rs);
+
+  for (const auto & it : rs.cm) {
+    for (const auto & it2 : it.second) {
+      const conversation_info& conv = it2.second;
+      auto wit = rs.em.find(conv.writer_guid);
+      auto rit = rs.em.find(conv.reader_guid);
+      if ((domain != 0xFF && domain != conv.domain_id) || wit == rs.em.end() || rit == rs.em.end()) {
+        continue;
+      }
+      double discovery_time = conv.first_evidence_time - std::max(wit->second.first_evidence_time, rit->second.first_evidence_time);
+      rs.discovery_times.record(discovery_time);
+      if (!is_guid_builtin(conv.writer_guid)) {
+        rs.user_discovery_times.record(discovery_time);
+      }
+      if (wit->second.topic_id != NO_TOPIC) {
+        rs.topic_discovery_times[rs.topics.topics[wit->second.topic_id].name].record(discovery_time);
+      }
+      rs.conversation_discovery_times[endpoint_key(rs, conv.writer_guid) + " >> " + endpoint_key(rs, conv.reader_guid)] = discovery_time;
+    }
+  }
+
+  for (const auto & it : frames) {
+    const rtps_frame& f = it.second;
+    if (f.data_vec.empty() && f.data_frag_vec.empty()) {
+      continue;
+    }
+    const std::string& writer_id = f.data_vec.empty() ? f.data_frag_vec.front().writer_id : f.data_vec.front().writer_id;
+    auto wit = rs.em.find(f.guid_prefix + writer_id);
+    if (wit != rs.em.end() && wit->second.topic_id != NO_TOPIC && (domain == 0xFF || domain == wit->second.domain_id)) {
+      rs.topic_bytes[rs.topics.topics[wit->second.topic_id].name] += f.udp_length;
+    }
+  }
+
+  gather_ip_fragment_stats(cap.ift, frames, rs.ifs);
+  gather_rtps_fragment_stats(frames, domain, frag_table_size, rs.rfs);
+}
+
+void print_run_comparison(std::ostream& os, const run_summary& a, const run_summary& b, size_t worst_count) {
+  os << "Comparison (A = " << a.filename << ", B = " << b.filename << "):" << std::endl;
+
+  std::map<std::string, std::string> a_roles;
+  std::map<std::string, std::string> b_roles;
+  for (const auto & it : a.participant_roles) {
+    a_roles[it.second] = it.first;
+  }
+  for (const auto & it : b.participant_roles) {
+    b_roles[it.second] = it.first;
+  }
+  std::map<std::string, std::string> a_endpoints;
+  std::map<std::string, std::string> b_endpoints;
+  for (const auto & it : a.endpoint_keys) {
+    a_endpoints[it.second] = it.first;
+  }
+  for (const auto & it : b.endpoint_keys) {
+    b_endpoints[it.second] = it.first;
+  }
+  size_t both = 0;
+  size_t only_a = 0;
+  size_t only_b = 0;
+  count_alignment(a_roles, b_roles, both, only_a, only_b);
+  os << " - Participants aligned by host / port: " << both << " (only in A: " << only_a << ", only in B: " << only_b << ")" << std::endl;
+  count_alignment(a_endpoints, b_endpoints, both, only_a, only_b);
+  os << " - Endpoints aligned by role / topic: " << both << " (only in A: " << only_a << ", only in B: " << only_b << ")" << std::endl;
+  count_alignment(a.topic_bytes, b.topic_bytes, both, only_a, only_b);
+  os << " - Topics with traffic in both: " << both << " (only in A: " << only_a << ", only in B: " << only_b << ")" << std::endl;
+  count_alignment(a.conversation_discovery_times, b.conversation_discovery_times, both, only_a, only_b);
+  os << " - Conversations aligned: " << both << " (only in A: " << only_a << ", only in B: " << only_b << ")" << std::endl;
+
+  print_count_delta(os, "Frames", a.frame_count, b.frame_count);
+  print_count_delta(os, "RTPS frames", a.rtps_frame_count, b.rtps_frame_count);
+  print_count_delta(os, "RTPS bytes", a.rtps_bytes, b.rtps_bytes);
+
+  print_histogram_deltas(os, "Discovery Times", a.discovery_times, b.discovery_times);
+  print_histogram_deltas(os, "Discovery Times (User Data Endpoints)", a.user_discovery_times, b.user_discovery_times);
+  print_histogram_deltas(os, "IP Fragment Reconstruction Times", a.ifs.reconstruction_times, b.ifs.reconstruction_times);
+  print_count_delta(os, "Incomplete IP datagrams", a.ifs.incomplete_count, b.ifs.incomplete_count);
+  print_histogram_deltas(os, "RTPS Fragment Reassembly Times", a.rfs.reassembly_times, b.rfs.reassembly_times);
+  print_count_delta(os, "Incomplete RTPS fragmented samples", a.rfs.incomplete_count, b.rfs.incomplete_count);
+
+  std::set<std::string> topic_names;
+  for (const auto & it : a.topic_bytes) {
+    topic_names.insert(it.first);
+  }
+  for (const auto & it : b.topic_bytes) {
+    topic_names.insert(it.first);
+  }
+  if (!topic_names.empty()) {
+    os << " - Traffic Volume By Topic (bytes):" << std::endl;
+    for (const auto & name : topic_names) {
+      auto ait = a.topic_bytes.find(name);
+      auto bit = b.topic_bytes.find(name);
+      size_t av = ait == a.topic_bytes.end() ? 0 : ait->second;
+      size_t bv = bit == b.topic_bytes.end() ? 0 : bit->second;
+      os << "   - " << name << ": " << av << " -> " << bv << " (" << std::showpos << static_cast<long long>(bv) - static_cast<long long>(av) << std::noshowpos << ")" << std::endl;
+    }
+  }
+
+  // Regressions: aligned topics by p99 discovery time, aligned conversations by discovery time
+  std::vector<std::pair<double, std::string>> topic_regressions;
+  for (const auto & it : a.topic_discovery_times) {
+    auto bit = b.topic_discovery_times.find(it.first);
+    if (bit != b.topic_discovery_times.end()) {
+      topic_regressions.emplace_back(bit->second.percentile(99.0) - it.second.percentile(99.0), it.first);
+    }
+  }
+  std::vector<std::pair<double, std::string>> conversation_regressions;
+  for (const auto & it : a.conversation_discovery_times) {
+    auto bit = b.conversation_discovery_times.find(it.first);
+    if (bit != b.conversation_discovery_times.end()) {
+      conversation_regressions.emplace_back(bit->second - it.second, it.first);
+    }
+  }
+  auto by_delta = [](const std::pair<double, std::string>& x, const std::pair<double, std::string>& y) { return x.first > y.first; };
+  std::stable_sort(topic_regressions.begin(), topic_regressions.end(), by_delta);
+  std::stable_sort(conversation_regressions.begin(), conversation_regressions.end(), by_delta);
+
+  os << std::fixed << std::setprecision(6);
+  os << " - Biggest Topic Regressions (P99 discovery time):" << std::endl;
+  for (size_t i = 0; i < topic_regressions.size() && i < worst_count && topic_regressions[i].first > 0.0; ++i) {
+    os << "   - " << topic_regressions[i].second << " +" << topic_regressions[i].first << " seconds" << std::endl;
+  }
+  os << " - Biggest Conversation Regressions (discovery time):" << std::endl;
+  for (size_t i = 0; i < conversation_regressions.size() && i < worst_count && conversation_regressions[i].first > 0.0; ++i) {
+    os << "   - " << conversation_regressions[i].second << " +" << conversation_regressions[i].first << " seconds" << std::endl;
+  }
+}
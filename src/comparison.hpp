@@ -0,0 +1,43 @@
+#pragma once
+
+#include "capture.hpp"
+#include "conversation_info.hpp"
+#include "endpoint_info.hpp"
+#include "hdr_histogram.hpp"
+#include "ip_fragments.hpp"
+#include "rtps_fragments.hpp"
+#include "topics.hpp"
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Everything one run contributes to a comparison. GUIDs change from run to run, so participants are keyed by their
+// host / port role (SPDP source address), endpoints by role, topic, kind and ordinal, and conversations by both endpoints.
+// The endpoint and conversation models point into the capture's frames, so the capture must outlive the summary.
+struct run_summary {
+  std::string filename;
+  endpoint_map em;
+  conversation_map cm;
+  topic_index topics;
+  size_t frame_count{0};
+  size_t rtps_frame_count{0};
+  size_t rtps_bytes{0};
+  hdr_histogram discovery_times;
+  hdr_histogram user_discovery_times;
+  ip_fragment_stats ifs;
+  rtps_fragment_stats rfs;
+  std::map<std::string, size_t> topic_bytes;
+  std::map<std::string, hdr_histogram> topic_discovery_times;
+  std::unordered_map<std::string, std::string> participant_roles; // guid prefix to role
+  std::map<std::string, std::string> endpoint_keys; // guid to aligned key
+  std::map<std::string, double> conversation_discovery_times; // aligned key to discovery time
+};
+
+void gather_run_summary(const capture& cap, uint16_t domain, size_t frag_table_size, run_summary& rs);
+
+// Prints b's deltas against a: discovery time percentiles, fragment reconstruction, traffic volume and the aligned
+// conversations and topics that regressed the most
+void print_run_comparison(std::ostream& os, const run_summary& a, const run_summary& b, size_t worst_count);
@@ -2,7 +2,47 @@
 
 #include "filtering.hpp"
 
+#include <algorithm>
+
+namespace {
+
+// Files a directed submessage under its conversation, creating the conversation on first sight
+template <typename T>
+void add_to_conversation(const rtps_frame& frame, const T& sm, std::vector<std::pair<const rtps_frame*, const T*>> conversation_info::* member, const char* kind, bool from_writer, const endpoint_map& em, conversation_map& cm) {
+  std::vector<rtps_info_dst>::const_iterator idit;
+  if ((idit = find_previous_dst(frame, sm.sm_order)) == frame.info_dst_vec.end()) {
+    return;
+  }
+  conversation_info info;
+  info.domain_id = static_cast<uint16_t>(frame.domain_id);
+  info.first_evidence_frame = frame.frame_no;
+  info.first_evidence_time = frame.frame_reference_time;
+  info.writer_guid = (from_writer ? frame.guid_prefix : idit->guid_prefix) + sm.writer_id;
+  info.reader_guid = (from_writer ? idit->guid_prefix : frame.guid_prefix) + sm.reader_id;
+  auto weit = em.find(info.writer_guid);
+  auto reit = em.find(info.reader_guid);
+  if (weit == em.end()) {
+    std::cout << "This shouldn't happen! " << kind << " writer " << info.writer_guid << " doesn't show up in endpoint map." << std::endl;
+  } else if (reit == em.end()) {
+    std::cout << "This shouldn't happen! " << kind << " reader " << info.reader_guid << " doesn't show up in endpoint map." << std::endl;
+  } else {
+    auto& readers = cm[info.writer_guid];
+    auto rcit = readers.find(info.reader_guid);
+    if (rcit == readers.end()) {
+      copy_endpoint_details_relevant_to_conversation(weit->second, reit->second, em, info);
+      rcit = readers.emplace(info.reader_guid, info).first;
+    }
+    (rcit->second.*member).emplace_back(&frame, &sm);
+  }
+}
+
+}
+
 void copy_endpoint_details_relevant_to_conversation(const endpoint_info& writer, const endpoint_info& reader, const endpoint_map& em, conversation_info& conv) {
+  // The RTPS header's domain is only tshark's guess from the UDP port, so the writer's own domain wins when it's known
+  if (writer.domain_id != 0xFF) {
+    conv.domain_id = static_cast<uint16_t>(writer.domain_id);
+  }
   size_t first_first_frame = reader.first_evidence_frame < writer.first_evidence_frame ? reader.first_evidence_frame : writer.first_evidence_frame;
   auto wpartrit = em.find(writer.guid.substr(0, 24) + "000100c7");
   auto rpartrit = em.find(reader.guid.substr(0, 24) + "000100c7");
@@ -32,6 +72,9 @@ void copy_endpoint_details_relevant_to_conversation(const endpoint_info& writer,
   filter_info_pair_vec_by_frame_and_reader_dst_full(writer.gaps, reader.first_evidence_frame, conv.reader_guid, reader.dst_net_map, conv.gaps);
   filter_info_pair_vec_by_frame_and_reader_dst_full(writer.heartbeats, reader.first_evidence_frame, conv.reader_guid, reader.dst_net_map, conv.heartbeats);
   filter_info_pair_vec_by_frame_and_writer_dst_full(reader.acknacks, writer.first_evidence_frame, conv.writer_guid, writer.dst_net_map, conv.acknacks);
+  filter_info_pair_vec_by_frame_and_reader_dst_full(writer.data_frags, reader.first_evidence_frame, conv.reader_guid, reader.dst_net_map, conv.data_frags);
+  filter_info_pair_vec_by_frame_and_reader_dst_full(writer.heartbeat_frags, reader.first_evidence_frame, conv.reader_guid, reader.dst_net_map, conv.heartbeat_frags);
+  filter_info_pair_vec_by_frame_and_writer_dst_full(reader.nack_frags, writer.first_evidence_frame, conv.writer_guid, writer.dst_net_map, conv.nack_frags);
 }
 
 void gather_conversation_info(const std::map<size_t, rtps_frame>& frames, const endpoint_map& em, conversation_map& cm) {
@@ -70,7 +113,7 @@ void gather_conversation_info(const std::map<size_t, rtps_frame>& frames, const
           }
         }
       } else {
-        if (dit->writer_id == "000004c2" && !dit->endpoint_guid.empty()) {
+        if (dit->writer_id == "000004c2" && !dit->endpoint_guid.empty() && !dit->disposed && !dit->unregistered) {
           for (auto it = dit->registered_writers.begin(); it != dit->registered_writers.end(); ++it) {
             info.writer_guid = *it;
             info.reader_guid = dit->endpoint_guid;
@@ -192,6 +235,86 @@ void gather_conversation_info(const std::map<size_t, rtps_frame>& frames, const
         }
       }
     }
+    for (const auto & data_frag : frame.second.data_frag_vec) {
+      add_to_conversation(frame.second, data_frag, &conversation_info::data_frags, "DataFrag", true, em, cm);
+    }
+    for (const auto & heartbeat_frag : frame.second.heartbeat_frag_vec) {
+      add_to_conversation(frame.second, heartbeat_frag, &conversation_info::heartbeat_frags, "HeartbeatFrag", true, em, cm);
+    }
+    for (const auto & nack_frag : frame.second.nack_frag_vec) {
+      add_to_conversation(frame.second, nack_frag, &conversation_info::nack_frags, "NackFrag", false, em, cm);
+    }
+  }
+}
+
+std::pair<const rtps_frame*, const rtps_frame*> conversation_traffic_span(const conversation_info& conv, bool from_writer) {
+  std::pair<const rtps_frame*, const rtps_frame*> span(nullptr, nullptr);
+  auto extend = [&](const rtps_frame* frame) {
+    if (span.first == nullptr || frame->frame_no < span.first->frame_no) {
+      span.first = frame;
+    }
+    if (span.second == nullptr || frame->frame_no > span.second->frame_no) {
+      span.second = frame;
+    }
+  };
+  if (from_writer) {
+    // datas also holds the SPDP / SEDP announcements that led up to the conversation, which aren't the writer's own traffic
+    std::for_each(conv.datas.begin(), conv.datas.end(), [&](const auto& v) {
+      if (v.first->guid_prefix + v.second->writer_id == conv.writer_guid) {
+        extend(v.first);
+      }
+    });
+    std::for_each(conv.gaps.begin(), conv.gaps.end(), [&](const auto& v) { extend(v.first); });
+    std::for_each(conv.heartbeats.begin(), conv.heartbeats.end(), [&](const auto& v) { extend(v.first); });
+    std::for_each(conv.data_frags.begin(), conv.data_frags.end(), [&](const auto& v) { extend(v.first); });
+    std::for_each(conv.heartbeat_frags.begin(), conv.heartbeat_frags.end(), [&](const auto& v) { extend(v.first); });
+  } else {
+    std::for_each(conv.acknacks.begin(), conv.acknacks.end(), [&](const auto& v) { extend(v.first); });
+    std::for_each(conv.nack_frags.begin(), conv.nack_frags.end(), [&](const auto& v) { extend(v.first); });
+  }
+  return span;
+}
+
+void gather_conversation_lifecycle(const endpoint_map& em, conversation_map& cm) {
+  for (auto & it : cm) {
+    for (auto & it2 : it.second) {
+      conversation_info& conv = it2.second;
+      conv.last_evidence_frame = conv.first_evidence_frame;
+      conv.last_evidence_time = conv.first_evidence_time;
+      for (bool from_writer : {true, false}) {
+        const rtps_frame* last = conversation_traffic_span(conv, from_writer).second;
+        if (last != nullptr && last->frame_no > conv.last_evidence_frame) {
+          conv.last_evidence_frame = last->frame_no;
+          conv.last_evidence_time = last->frame_reference_time;
+        }
+      }
+
+      // The conversation ends with whichever side ends first
+      for (const auto & guid : {conv.writer_guid, conv.reader_guid}) {
+        auto eit = em.find(guid);
+        if (eit != em.end() && eit->second.end_reason != EER_NONE && (conv.end_reason == EER_NONE || eit->second.end_evidence_time < conv.end_evidence_time)) {
+          conv.end_evidence_frame = eit->second.end_evidence_frame;
+          conv.end_evidence_time = eit->second.end_evidence_time;
+          conv.end_reason = eit->second.end_reason;
+        }
+      }
+    }
   }
 }
 
+std::set<size_t> gather_conversation_frames(const endpoint_info& writer, const endpoint_info& reader, const conversation_info& conv) {
+  std::set<size_t> cframes = {writer.first_evidence_frame, reader.first_evidence_frame, conv.first_evidence_frame};
+  auto insert_frames = [&](const auto& pairs) {
+    for (const auto & p : pairs) {
+      cframes.insert(p.first->frame_no);
+    }
+  };
+  insert_frames(conv.datas);
+  insert_frames(conv.gaps);
+  insert_frames(conv.heartbeats);
+  insert_frames(conv.acknacks);
+  insert_frames(conv.data_frags);
+  insert_frames(conv.heartbeat_frags);
+  insert_frames(conv.nack_frags);
+  return cframes;
+}
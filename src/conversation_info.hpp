@@ -3,7 +3,9 @@
 #include "endpoint_info.hpp"
 #include "info_pairs.hpp"
 
+#include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 struct conversation_info {
@@ -12,10 +14,18 @@ struct conversation_info {
   uint16_t domain_id;
   size_t first_evidence_frame;
   double first_evidence_time;
+  size_t last_evidence_frame{0};
+  double last_evidence_time{-1.0};
+  size_t end_evidence_frame{0};
+  double end_evidence_time{-1.0};
+  endpoint_end_reason end_reason{EER_NONE};
   std::vector<data_info_pair> datas;
   std::vector<gap_info_pair> gaps;
   std::vector<hb_info_pair> heartbeats;
   std::vector<an_info_pair> acknacks;
+  std::vector<df_info_pair> data_frags;
+  std::vector<hbf_info_pair> heartbeat_frags;
+  std::vector<nf_info_pair> nack_frags;
 };
 
 using conversation_map = std::map<std::string, std::map<std::string, conversation_info>>;
@@ -23,3 +33,13 @@ using conversation_map = std::map<std::string, std::map<std::string, conversatio
 void copy_endpoint_details_relevant_to_conversation(const endpoint_info& writer, const endpoint_info& reader, const endpoint_map& em, conversation_info& conv);
 void gather_conversation_info(const rtps_frame_map& frames, const endpoint_map& em, conversation_map& cm);
 
+// First and last frame carrying traffic from the writer to the reader (or, with from_writer unset, from the reader to the writer)
+std::pair<const rtps_frame*, const rtps_frame*> conversation_traffic_span(const conversation_info& conv, bool from_writer);
+
+// Frames relevant to a conversation: first evidence of both endpoints and of the conversation itself, plus every frame
+// carrying one of the conversation's submessages
+std::set<size_t> gather_conversation_frames(const endpoint_info& writer, const endpoint_info& reader, const conversation_info& conv);
+
+// Fills in last evidence from the conversation's traffic and end evidence from the earlier of the two endpoints' ends
+void gather_conversation_lifecycle(const endpoint_map& em, conversation_map& cm);
+
@@ -0,0 +1,281 @@
+#include "correlation.hpp"
+#include "utils.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <thread>
+#include <unordered_map>
+
+namespace {
+
+struct sample_key {
+  uint64_t hi;
+  uint64_t lo;
+  uint64_t seq;
+};
+
+bool operator==(const sample_key& a, const sample_key& b) {
+  return a.hi == b.hi && a.lo == b.lo && a.seq == b.seq;
+}
+
+struct sample_slot {
+  sample_key key;
+  double epoch_time;
+  uint32_t host;
+  bool used;
+};
+
+// Open addressing with linear probing keeps every sighting in one flat allocation, which matters at tens of millions of samples
+struct sample_index {
+  std::vector<sample_slot> slots;
+  size_t mask{0};
+  size_t size{0};
+  string_vec hosts;
+};
+
+uint64_t mix(uint64_t v) {
+  v += 0x9e3779b97f4a7c15ull;
+  v = (v ^ (v >> 30u)) * 0xbf58476d1ce4e5b9ull;
+  v = (v ^ (v >> 27u)) * 0x94d049bb133111ebull;
+  return v ^ (v >> 31u);
+}
+
+size_t slot_for(const sample_index& index, const sample_key& key) {
+  auto pos = static_cast<size_t>(mix(key.hi ^ mix(key.lo ^ mix(key.seq)))) & index.mask;
+  while (index.slots[pos].used && !(index.slots[pos].key == key)) {
+    pos = (pos + 1) & index.mask;
+  }
+  return pos;
+}
+
+bool parse_hex(const std::string& str, size_t pos, size_t len, uint64_t& out) {
+  out = 0;
+  if (str.size() < pos + len) {
+    return false;
+  }
+  for (size_t i = pos; i < pos + len; ++i) {
+    char c = str[i];
+    uint64_t nibble = 0;
+    if (c >= '0' && c <= '9') {
+      nibble = static_cast<uint64_t>(c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+      nibble = static_cast<uint64_t>(c - 'a' + 10);
+    } else if (c >= 'A' && c <= 'F') {
+      nibble = static_cast<uint64_t>(c - 'A' + 10);
+    } else {
+      return false;
+    }
+    out = (out << 4u) | nibble;
+  }
+  return true;
+}
+
+void build_sample_index(const capture& cap, sample_index& index) {
+  size_t expected = 0;
+  for (const auto & frame : cap.frames) {
+    expected += frame.second.data_vec.size();
+  }
+  size_t capacity = 16;
+  while (capacity < expected * 2) {
+    capacity <<= 1u;
+  }
+  index.slots.assign(capacity, sample_slot{sample_key{0, 0, 0}, 0.0, 0, false});
+  index.mask = capacity - 1;
+
+  std::unordered_map<std::string, uint32_t> host_ids;
+  for (const auto & frame : cap.frames) {
+    const rtps_frame& f = frame.second;
+    uint64_t hi = 0;
+    uint64_t prefix_lo = 0;
+    if (f.data_vec.empty() || !parse_hex(f.guid_prefix, 0, 16, hi) || !parse_hex(f.guid_prefix, 16, 8, prefix_lo)) {
+      continue;
+    }
+    auto hit = host_ids.find(f.src_ip);
+    if (hit == host_ids.end()) {
+      hit = host_ids.emplace(f.src_ip, static_cast<uint32_t>(index.hosts.size())).first;
+      index.hosts.push_back(f.src_ip);
+    }
+    for (const auto & data : f.data_vec) {
+      uint64_t entity = 0;
+      if (data.writer_seq_num == 0 || !parse_hex(data.writer_id, 0, 8, entity)) {
+        continue;
+      }
+      sample_key key{hi, (prefix_lo << 32u) | entity, data.writer_seq_num};
+      sample_slot& slot = index.slots[slot_for(index, key)];
+      // Frames are visited in capture order, so the first sighting wins
+      if (!slot.used) {
+        slot = sample_slot{key, f.frame_epoch_time, hit->second, true};
+        ++index.size;
+      }
+    }
+  }
+}
+
+// The capturing host takes part in every unicast frame it records, so it is the unicast address seen most often
+std::string guess_capture_host(const capture& cap) {
+  std::unordered_map<std::string, size_t> counts;
+  for (const auto & frame : cap.frames) {
+    ++counts[frame.second.src_ip];
+    if (!is_ip_multicast(frame.second.dst_ip)) {
+      ++counts[frame.second.dst_ip];
+    }
+  }
+  auto best = std::max_element(counts.begin(), counts.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+  return best == counts.end() ? std::string() : best->first;
+}
+
+void correlate_pair(const sample_index& a, const sample_index& b, const std::string& host_a, const std::string& host_b, capture_pair_correlation& pc) {
+  const double inf = std::numeric_limits<double>::infinity();
+  double min_forward = inf;
+  double min_reverse = inf;
+  for (const auto & slot : a.slots) {
+    if (!slot.used) {
+      continue;
+    }
+    const sample_slot& other = b.slots[slot_for(b, slot.key)];
+    const std::string& writer_host = a.hosts[slot.host];
+    if (!other.used) {
+      if (writer_host == host_a) {
+        ++pc.forward_missing;
+      }
+      continue;
+    }
+    ++pc.matched_count;
+    double delta = other.epoch_time - slot.epoch_time;
+    if (writer_host == host_a) {
+      ++pc.forward_count;
+      min_forward = std::min(min_forward, delta);
+    } else if (writer_host == host_b) {
+      ++pc.reverse_count;
+      min_reverse = std::min(min_reverse, -delta);
+    } else {
+      ++pc.other_count;
+    }
+  }
+  for (const auto & slot : b.slots) {
+    if (slot.used && b.hosts[slot.host] == host_b && !a.slots[slot_for(a, slot.key)].used) {
+      ++pc.reverse_missing;
+    }
+  }
+
+  // delta = offset + forward latency and -delta = -offset + reverse latency, so with traffic both ways the
+  // minimum delays cancel (as in NTP); with one direction only the minimum latency is assumed to be zero
+  if (pc.forward_count != 0 && pc.reverse_count != 0) {
+    pc.clock_offset = (min_forward - min_reverse) / 2.0;
+    pc.offset_method = "symmetric minimum delay";
+    pc.offset_known = true;
+  } else if (pc.forward_count != 0) {
+    pc.clock_offset = min_forward;
+    pc.offset_method = "forward minimum delay (latencies are relative to the fastest sample)";
+    pc.offset_known = true;
+  } else if (pc.reverse_count != 0) {
+    pc.clock_offset = -min_reverse;
+    pc.offset_method = "reverse minimum delay (latencies are relative to the fastest sample)";
+    pc.offset_known = true;
+  }
+  if (!pc.offset_known) {
+    return;
+  }
+
+  for (const auto & slot : a.slots) {
+    if (!slot.used) {
+      continue;
+    }
+    const std::string& writer_host = a.hosts[slot.host];
+    if (writer_host != host_a && writer_host != host_b) {
+      continue;
+    }
+    const sample_slot& other = b.slots[slot_for(b, slot.key)];
+    if (other.used) {
+      double delta = other.epoch_time - slot.epoch_time - pc.clock_offset;
+      if (writer_host == host_a) {
+        pc.forward_latency.record(delta);
+      } else {
+        pc.reverse_latency.record(-delta);
+      }
+    }
+  }
+}
+
+}
+
+void correlate_captures(const std::vector<capture>& caps, capture_correlation& cc) {
+  std::vector<sample_index> indices(caps.size());
+  cc.hosts.assign(caps.size(), std::string());
+  cc.sample_counts.assign(caps.size(), 0);
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < caps.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      build_sample_index(caps[i], indices[i]);
+      cc.hosts[i] = guess_capture_host(caps[i]);
+      cc.sample_counts[i] = indices[i].size;
+    });
+  }
+  for (auto & t : threads) {
+    t.join();
+  }
+
+  for (size_t i = 0; i < caps.size(); ++i) {
+    for (size_t j = i + 1; j < caps.size(); ++j) {
+      cc.pairs.emplace_back();
+      capture_pair_correlation& pc = cc.pairs.back();
+      pc.first = i;
+      pc.second = j;
+      correlate_pair(indices[i], indices[j], cc.hosts[i], cc.hosts[j], pc);
+    }
+  }
+
+  // Pairs of receivers can't see each other's traffic, but their offsets still follow from the first capture's offsets
+  auto find_pair = [&](size_t i, size_t j) {
+    return std::find_if(cc.pairs.begin(), cc.pairs.end(), [&](const capture_pair_correlation& p) { return p.first == i && p.second == j; });
+  };
+  for (auto & pc : cc.pairs) {
+    if (!pc.offset_known && pc.first != 0) {
+      auto a = find_pair(0, pc.first);
+      auto b = find_pair(0, pc.second);
+      if (a != cc.pairs.end() && b != cc.pairs.end() && a->offset_known && b->offset_known) {
+        pc.clock_offset = b->clock_offset - a->clock_offset;
+        pc.offset_method = "derived from offsets to " + caps[0].filename;
+        pc.offset_known = true;
+      }
+    }
+  }
+}
+
+void print_correlation_stats(std::ostream& os, const std::vector<capture>& caps, const capture_correlation& cc, bool show_histograms) {
+  os << "Capture Correlation:" << std::endl;
+  for (size_t i = 0; i < caps.size(); ++i) {
+    os << " - Capture " << i << ": " << caps[i].filename << " (host " << cc.hosts[i] << ", " << cc.sample_counts[i] << " unique samples)" << std::endl;
+  }
+  for (const auto & pc : cc.pairs) {
+    const std::string& a = caps[pc.first].filename;
+    const std::string& b = caps[pc.second].filename;
+    os << " - " << a << " >> " << b << ":" << std::endl;
+    os << "   - Matched samples: " << pc.matched_count << " (from " << cc.hosts[pc.first] << ": " << pc.forward_count
+       << ", from " << cc.hosts[pc.second] << ": " << pc.reverse_count << ", from other hosts: " << pc.other_count << ")" << std::endl;
+    os << "   - Samples from " << cc.hosts[pc.first] << " missing in " << b << ": " << pc.forward_missing << std::endl;
+    os << "   - Samples from " << cc.hosts[pc.second] << " missing in " << a << ": " << pc.reverse_missing << std::endl;
+    if (!pc.offset_known) {
+      os << "   - Clock offset: unknown (no samples were sent from either capture host)" << std::endl;
+      continue;
+    }
+    os << "   - Clock offset (" << b << " - " << a << "): " << std::showpos << std::fixed << std::setprecision(6) << pc.clock_offset << std::noshowpos
+       << " s (" << pc.offset_method << ")" << std::endl;
+    if (pc.forward_latency.count() != 0) {
+      os << "   - Delivery Latency " << cc.hosts[pc.first] << " -> " << cc.hosts[pc.second] << ":" << std::endl;
+      pc.forward_latency.print_summary(os, "     ");
+      if (show_histograms) {
+        pc.forward_latency.print_histogram(os, "       ");
+      }
+    }
+    if (pc.reverse_latency.count() != 0) {
+      os << "   - Delivery Latency " << cc.hosts[pc.second] << " -> " << cc.hosts[pc.first] << ":" << std::endl;
+      pc.reverse_latency.print_summary(os, "     ");
+      if (show_histograms) {
+        pc.reverse_latency.print_histogram(os, "       ");
+      }
+    }
+  }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "capture.hpp"
+#include "hdr_histogram.hpp"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct capture_pair_correlation {
+  size_t first{0};
+  size_t second{0};
+  size_t matched_count{0};
+  size_t forward_count{0};
+  size_t reverse_count{0};
+  size_t other_count{0};
+  size_t forward_missing{0};
+  size_t reverse_missing{0};
+  bool offset_known{false};
+  double clock_offset{0.0};
+  std::string offset_method;
+  hdr_histogram forward_latency;
+  hdr_histogram reverse_latency;
+};
+
+struct capture_correlation {
+  string_vec hosts;
+  std::vector<size_t> sample_counts;
+  std::vector<capture_pair_correlation> pairs;
+};
+
+// Matches DATA samples by (writer GUID, writer_seq_num) across simultaneous captures taken on different hosts,
+// estimates a constant clock offset for each capture pair and measures per-hop delivery latency from frame_epoch_time
+void correlate_captures(const std::vector<capture>& caps, capture_correlation& cc);
+void print_correlation_stats(std::ostream& os, const std::vector<capture>& caps, const capture_correlation& cc, bool show_histograms);
@@ -0,0 +1,223 @@
+#include "discovery_phases.hpp"
+
+#include "utils.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+
+namespace {
+
+const size_t guid_prefix_length = 24;
+const double unseen = std::numeric_limits<double>::infinity();
+
+// Earliest acknack on a builtin SEDP conversation that acknowledges seq_num, sent no earlier than time
+double find_sedp_ack_time(const conversation_map& cm, const std::string& writer_guid, const std::string& reader_guid, size_t seq_num, double time) {
+  auto wit = cm.find(writer_guid);
+  if (wit == cm.end()) {
+    return unseen;
+  }
+  auto rit = wit->second.find(reader_guid);
+  if (rit == wit->second.end()) {
+    return unseen;
+  }
+  double result = unseen;
+  for (const auto & an : rit->second.acknacks) {
+    if (an.second->bitmap.base > seq_num && an.first->frame_reference_time >= time) {
+      result = std::min(result, an.first->frame_reference_time);
+    }
+  }
+  return result;
+}
+
+template <typename T>
+double first_time(const std::vector<std::pair<const rtps_frame*, const T*>>& vec) {
+  double result = unseen;
+  for (const auto & v : vec) {
+    result = std::min(result, v.first->frame_reference_time);
+  }
+  return result;
+}
+
+// Times of the participant's SPDP announcements (they're filed under its SPDP writer rather than its endpoints)
+std::vector<double> spdp_times(const endpoint_map& em, const std::string& prefix) {
+  std::vector<double> result;
+  auto it = em.find(prefix + "000100c2");
+  if (it != em.end()) {
+    for (const auto & d : it->second.spdp_announcements) {
+      result.push_back(d.first->frame_reference_time);
+    }
+  }
+  return result;
+}
+
+void gather_conversation_phases(const endpoint_map& em, const conversation_map& cm, const conversation_info& conv, conversation_phases& cp) {
+  const std::string writer_prefix = conv.writer_guid.substr(0, guid_prefix_length);
+  const std::string reader_prefix = conv.reader_guid.substr(0, guid_prefix_length);
+  const std::string writer_id = conv.writer_guid.substr(guid_prefix_length);
+
+  const std::vector<double> writer_spdp = spdp_times(em, writer_prefix);
+  const std::vector<double> reader_spdp = spdp_times(em, reader_prefix);
+  double writer_sedp = unseen;
+  double reader_sedp = unseen;
+  double writer_sedp_ack = unseen;
+  double reader_sedp_ack = unseen;
+  double user_data = first_time(conv.data_frags);
+  // conv.datas holds the SEDP announcements relevant to the conversation followed by its user data
+  for (const auto & d : conv.datas) {
+    double time = d.first->frame_reference_time;
+    if (d.second->endpoint_guid == conv.writer_guid && time < writer_sedp) {
+      writer_sedp = time;
+      writer_sedp_ack = find_sedp_ack_time(cm, writer_prefix + "000003c2", reader_prefix + "000003c7", d.second->writer_seq_num, time);
+    } else if (d.second->endpoint_guid == conv.reader_guid && time < reader_sedp) {
+      reader_sedp = time;
+      reader_sedp_ack = find_sedp_ack_time(cm, reader_prefix + "000004c2", writer_prefix + "000004c7", d.second->writer_seq_num, time);
+    } else if (d.first->guid_prefix == writer_prefix && d.second->writer_id == writer_id) {
+      user_data = std::min(user_data, time);
+    }
+  }
+
+  // Each side has seen the other's participant once both have announced themselves after the later one first did
+  double writer_first_spdp = writer_spdp.empty() ? unseen : *std::min_element(writer_spdp.begin(), writer_spdp.end());
+  double reader_first_spdp = reader_spdp.empty() ? unseen : *std::min_element(reader_spdp.begin(), reader_spdp.end());
+  double start = std::max(writer_first_spdp, reader_first_spdp);
+  double spdp_mutual = unseen;
+  if (start != unseen) {
+    auto first_since = [start](const std::vector<double>& times) {
+      double result = unseen;
+      for (double t : times) {
+        if (t >= start) {
+          result = std::min(result, t);
+        }
+      }
+      return result;
+    };
+    // Sending SEDP to the other participant is also evidence of having seen its SPDP announcement
+    spdp_mutual = std::max(std::min(first_since(writer_spdp), writer_sedp), std::min(first_since(reader_spdp), reader_sedp));
+  } else {
+    // Without both participants' announcements the earliest SEDP announcement is the best available starting point
+    start = std::min(std::min(writer_sedp, reader_sedp), conv.first_evidence_time);
+  }
+
+  const double milestones[DP_COUNT] = {
+    spdp_mutual,
+    std::max(writer_sedp, reader_sedp),
+    std::max(writer_sedp_ack, reader_sedp_ack),
+    first_time(conv.heartbeats),
+    first_time(conv.acknacks),
+    user_data
+  };
+
+  cp.conv = &conv;
+  cp.start_time = start;
+  double latest = start;
+  double longest = -1.0;
+  for (size_t p = 0; p < DP_COUNT; ++p) {
+    if (milestones[p] == unseen) {
+      continue;
+    }
+    cp.observed[p] = true;
+    cp.durations[p] = std::max(milestones[p] - latest, 0.0);
+    latest = std::max(latest, milestones[p]);
+    if (cp.durations[p] > longest) {
+      longest = cp.durations[p];
+      cp.dominant = static_cast<discovery_phase>(p);
+    }
+  }
+  cp.total = latest - start;
+}
+
+}
+
+const char* discovery_phase_name(discovery_phase phase) {
+  switch (phase) {
+    case DP_SPDP:
+      return "SPDP seen by each side";
+    case DP_SEDP_SENT:
+      return "SEDP announcements sent";
+    case DP_SEDP_ACKED:
+      return "SEDP announcements acked";
+    case DP_FIRST_HEARTBEAT:
+      return "First HEARTBEAT";
+    case DP_FIRST_ACKNACK:
+      return "First ACKNACK";
+    case DP_FIRST_USER_DATA:
+      return "First user DATA";
+    case DP_COUNT:
+    default:
+      return "unknown";
+  }
+}
+
+void gather_discovery_phase_info(const endpoint_map& em, const conversation_map& cm, uint16_t domain, discovery_phase_info& dpi) {
+  for (const auto & it : cm) {
+    for (const auto & it2 : it.second) {
+      const conversation_info& conv = it2.second;
+      if ((domain != 0xFF && domain != conv.domain_id) || is_guid_builtin(conv.writer_guid)) {
+        continue;
+      }
+      conversation_phases cp;
+      gather_conversation_phases(em, cm, conv, cp);
+      for (size_t p = 0; p < DP_COUNT; ++p) {
+        if (cp.observed[p]) {
+          dpi.phase_times[p].record(cp.durations[p]);
+        }
+      }
+      dpi.total_time.record(cp.total);
+      dpi.conversations.push_back(cp);
+    }
+  }
+
+  std::stable_sort(dpi.conversations.begin(), dpi.conversations.end(), [](const conversation_phases& a, const conversation_phases& b) { return a.total > b.total; });
+  dpi.tail_count = dpi.conversations.empty() ? 0 : (dpi.conversations.size() + 9) / 10;
+  for (size_t i = 0; i < dpi.tail_count; ++i) {
+    const conversation_phases& cp = dpi.conversations[i];
+    for (size_t p = 0; p < DP_COUNT; ++p) {
+      dpi.tail_phase_time[p] += cp.durations[p];
+    }
+    ++dpi.tail_dominant_count[cp.dominant];
+  }
+}
+
+void print_discovery_phase_stats(std::ostream& os, const discovery_phase_info& dpi, size_t worst_count, bool show_histograms) {
+  os << "Discovery Phase Stats:" << std::endl;
+  os << " - User conversations: " << dpi.conversations.size() << std::endl;
+  os << " - Total (later participant's first SPDP to last milestone):" << std::endl;
+  dpi.total_time.print_summary(os, "   ");
+  for (size_t p = 0; p < DP_COUNT; ++p) {
+    os << " - " << discovery_phase_name(static_cast<discovery_phase>(p)) << ":" << std::endl;
+    dpi.phase_times[p].print_summary(os, "   ");
+    if (show_histograms) {
+      dpi.phase_times[p].print_histogram(os, "     ");
+    }
+  }
+  if (dpi.tail_count == 0) {
+    return;
+  }
+
+  double tail_total = 0.0;
+  size_t dominant = 0;
+  for (size_t p = 0; p < DP_COUNT; ++p) {
+    tail_total += dpi.tail_phase_time[p];
+    if (dpi.tail_phase_time[p] > dpi.tail_phase_time[dominant]) {
+      dominant = p;
+    }
+  }
+  os << " - Slow Tail (slowest " << dpi.tail_count << " conversations):" << std::endl;
+  os << std::fixed;
+  for (size_t p = 0; p < DP_COUNT; ++p) {
+    os << "   - " << std::left << std::setw(26) << discovery_phase_name(static_cast<discovery_phase>(p)) << std::right
+       << std::setprecision(6) << std::setw(12) << dpi.tail_phase_time[p] << " seconds ("
+       << std::setprecision(1) << std::setw(5) << (tail_total > 0.0 ? 100.0 * dpi.tail_phase_time[p] / tail_total : 0.0) << "%), longest phase in "
+       << dpi.tail_dominant_count[p] << std::endl;
+  }
+  os << "   - Dominant phase: " << discovery_phase_name(static_cast<discovery_phase>(dominant)) << std::endl;
+
+  os << " - Slowest Conversations:" << std::endl;
+  os << std::setprecision(6);
+  for (size_t i = 0; i < dpi.conversations.size() && i < worst_count; ++i) {
+    const conversation_phases& cp = dpi.conversations[i];
+    os << "   - " << cp.conv->writer_guid << " >> " << cp.conv->reader_guid << " took " << cp.total << " seconds (longest phase: "
+       << discovery_phase_name(cp.dominant) << ", " << cp.durations[cp.dominant] << " seconds)" << std::endl;
+  }
+}
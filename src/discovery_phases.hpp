@@ -0,0 +1,46 @@
+#pragma once
+
+#include "conversation_info.hpp"
+#include "endpoint_info.hpp"
+#include "hdr_histogram.hpp"
+
+#include <ostream>
+#include <vector>
+
+enum discovery_phase : uint8_t {
+  DP_SPDP,            // later participant's first SPDP announcement until each side has announced itself (or sent SEDP) since then
+  DP_SEDP_SENT,       // until both endpoints' SEDP announcements were sent
+  DP_SEDP_ACKED,      // until both SEDP announcements were acknowledged by the remote builtin readers
+  DP_FIRST_HEARTBEAT, // until the writer's first HEARTBEAT to the reader
+  DP_FIRST_ACKNACK,   // until the reader's first ACKNACK to the writer
+  DP_FIRST_USER_DATA, // until the writer's first user DATA / DATA_FRAG to the reader
+  DP_COUNT
+};
+
+const char* discovery_phase_name(discovery_phase phase);
+
+struct conversation_phases {
+  const conversation_info* conv{nullptr};
+  double start_time{0.0};
+  double total{0.0}; // start to the last milestone observed
+  double durations[DP_COUNT]{};
+  bool observed[DP_COUNT]{};
+  discovery_phase dominant{DP_SPDP};
+};
+
+struct discovery_phase_info {
+  std::vector<conversation_phases> conversations; // sorted by total, slowest first
+  hdr_histogram phase_times[DP_COUNT];
+  hdr_histogram total_time;
+  // Over the slowest 10% of conversations: time spent in each phase and how often it was the longest one
+  size_t tail_count{0};
+  double tail_phase_time[DP_COUNT]{};
+  size_t tail_dominant_count[DP_COUNT]{};
+};
+
+// Breaks every user conversation's discovery into consecutive phases using the participants' SPDP announcements, the SEDP
+// announcements filed under the conversation, acknacks of the builtin SEDP conversations and the conversation's own first traffic.
+// Milestones are visited in phase order and each phase is measured from the latest milestone before it, so overlapping
+// phases count as zero and missing milestones are skipped.
+void gather_discovery_phase_info(const endpoint_map& em, const conversation_map& cm, uint16_t domain, discovery_phase_info& dpi);
+void print_discovery_phase_stats(std::ostream& os, const discovery_phase_info& dpi, size_t worst_count, bool show_histograms);
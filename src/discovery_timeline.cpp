@@ -0,0 +1,141 @@
+#include "discovery_timeline.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <unordered_map>
+
+namespace {
+
+enum timeline_event_kind : uint8_t {
+  TEK_PARTICIPANT,
+  TEK_ENDPOINT,
+  TEK_CONVERSATION
+};
+
+const size_t guid_prefix_length = 24;
+
+bool is_participant_guid(const std::string& guid) {
+  return guid.compare(guid_prefix_length, std::string::npos, "000100c2") == 0;
+}
+
+void note_conversation(std::unordered_map<std::string, size_t>& index, std::vector<participant_discovery>& participants, const std::string& guid, double time) {
+  auto it = index.find(guid.substr(0, guid_prefix_length));
+  if (it == index.end()) {
+    return;
+  }
+  participant_discovery& pd = participants[it->second];
+  ++pd.conversation_count;
+  pd.complete_time = std::max(pd.complete_time, time);
+}
+
+}
+
+void gather_discovery_timeline_info(const endpoint_map& em, const conversation_map& cm, uint16_t domain, discovery_timeline_info& dti) {
+  std::vector<std::pair<double, timeline_event_kind>> events;
+  std::unordered_map<std::string, size_t> participant_index;
+  for (const auto & it : em) {
+    const endpoint_info& info = it.second;
+    if ((domain != 0xFF && domain != info.domain_id) || info.guid.length() != 32) {
+      continue;
+    }
+    if (!is_participant_guid(info.guid)) {
+      events.emplace_back(info.first_evidence_time, TEK_ENDPOINT);
+      continue;
+    }
+    events.emplace_back(info.first_evidence_time, TEK_PARTICIPANT);
+    participant_discovery pd;
+    pd.guid_prefix = info.guid.substr(0, guid_prefix_length);
+    pd.announce_time = info.spdp_announcements.empty() ? info.first_evidence_time : info.spdp_announcements.front().first->frame_reference_time;
+    participant_index[pd.guid_prefix] = dti.participants.size();
+    dti.participants.push_back(pd);
+  }
+
+  for (const auto & it : cm) {
+    for (const auto & it2 : it.second) {
+      const conversation_info& conv = it2.second;
+      if (domain != 0xFF && domain != conv.domain_id) {
+        continue;
+      }
+      events.emplace_back(conv.first_evidence_time, TEK_CONVERSATION);
+      note_conversation(participant_index, dti.participants, conv.writer_guid, conv.first_evidence_time);
+      note_conversation(participant_index, dti.participants, conv.reader_guid, conv.first_evidence_time);
+    }
+  }
+
+  std::sort(events.begin(), events.end());
+  size_t counts[TEK_CONVERSATION + 1]{};
+  for (size_t i = 0; i < events.size(); ++i) {
+    ++counts[events[i].second];
+    if (i + 1 < events.size() && events[i + 1].first == events[i].first) {
+      continue;
+    }
+    dti.timeline.push_back(discovery_timeline_point{events[i].first, counts[TEK_PARTICIPANT], counts[TEK_ENDPOINT], counts[TEK_CONVERSATION]});
+  }
+
+  for (const auto & pd : dti.participants) {
+    if (pd.conversation_count == 0) {
+      ++dti.undiscovered_participant_count;
+    } else {
+      dti.full_discovery_time.record(std::max(pd.complete_time - pd.announce_time, 0.0));
+    }
+  }
+  std::stable_sort(dti.participants.begin(), dti.participants.end(), [](const participant_discovery& a, const participant_discovery& b) {
+    return (a.complete_time - a.announce_time) > (b.complete_time - b.announce_time);
+  });
+}
+
+void print_discovery_timeline_stats(std::ostream& os, const discovery_timeline_info& dti, size_t worst_count, bool show_histograms) {
+  os << "Discovery Timeline Stats:" << std::endl;
+  os << " - Participants: " << dti.participants.size() << " (without any conversation: " << dti.undiscovered_participant_count << ")" << std::endl;
+  if (!dti.timeline.empty()) {
+    const discovery_timeline_point& last = dti.timeline.back();
+    os << " - Final counts at time " << std::fixed << std::setprecision(3) << last.time << ": " << last.participants << " participants, "
+       << last.endpoints << " endpoints, " << last.conversations << " conversations" << std::endl;
+    // Time at which each count first reached half and all of its final value
+    auto report = [&](const char* name, size_t discovery_timeline_point::* member) {
+      size_t final_count = last.*member;
+      double half_time = last.time;
+      double full_time = last.time;
+      for (auto it = dti.timeline.rbegin(); it != dti.timeline.rend(); ++it) {
+        if ((*it).*member * 2 >= final_count) {
+          half_time = it->time;
+        }
+        if ((*it).*member == final_count) {
+          full_time = it->time;
+        }
+      }
+      os << " - " << name << ": 50% at time " << half_time << ", 100% at time " << full_time << std::endl;
+    };
+    report("Participants", &discovery_timeline_point::participants);
+    report("Endpoints", &discovery_timeline_point::endpoints);
+    report("Conversations", &discovery_timeline_point::conversations);
+  }
+  os << " - Time To Full Discovery (first SPDP announcement to last conversation of the participant's endpoints):" << std::endl;
+  dti.full_discovery_time.print_summary(os, "   ");
+  if (show_histograms) {
+    dti.full_discovery_time.print_histogram(os, "     ");
+  }
+  size_t shown = 0;
+  for (const auto & pd : dti.participants) {
+    if (shown == worst_count) {
+      break;
+    }
+    if (pd.conversation_count == 0) {
+      continue;
+    }
+    if (shown++ == 0) {
+      os << " - Slowest Participants:" << std::endl;
+    }
+    os << "   - " << pd.guid_prefix << " took " << std::fixed << std::setprecision(6) << pd.complete_time - pd.announce_time
+       << " seconds (" << pd.conversation_count << " conversations, announced at " << pd.announce_time << ")" << std::endl;
+  }
+}
+
+void write_discovery_timeline_csv(std::ostream& os, const discovery_timeline_info& dti) {
+  os << "time,participants,endpoints,conversations\n";
+  os << std::fixed << std::setprecision(6);
+  for (const auto & it : dti.timeline) {
+    os << it.time << ',' << it.participants << ',' << it.endpoints << ',' << it.conversations << '\n';
+  }
+  os << std::flush;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "conversation_info.hpp"
+#include "endpoint_info.hpp"
+#include "hdr_histogram.hpp"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+struct discovery_timeline_point {
+  double time;
+  size_t participants;
+  size_t endpoints;
+  size_t conversations;
+};
+
+struct participant_discovery {
+  std::string guid_prefix;
+  double announce_time{-1.0}; // first SPDP announcement (or first evidence, if no announcement was captured)
+  double complete_time{-1.0}; // first evidence of the last conversation involving one of its endpoints
+  size_t conversation_count{0};
+};
+
+struct discovery_timeline_info {
+  std::vector<discovery_timeline_point> timeline; // cumulative counts, one entry per distinct first evidence time
+  std::vector<participant_discovery> participants; // sorted by time to full discovery, slowest first
+  size_t undiscovered_participant_count{0}; // participants without any conversation
+  hdr_histogram full_discovery_time;
+};
+
+// Sorts the first evidence times of participants (SPDP writers), other endpoints and conversations into a cumulative
+// timeline, and measures each participant's time from first SPDP announcement to the last of its conversations forming
+void gather_discovery_timeline_info(const endpoint_map& em, const conversation_map& cm, uint16_t domain, discovery_timeline_info& dti);
+void print_discovery_timeline_stats(std::ostream& os, const discovery_timeline_info& dti, size_t worst_count, bool show_histograms);
+void write_discovery_timeline_csv(std::ostream& os, const discovery_timeline_info& dti);
@@ -4,8 +4,24 @@
 #include <iomanip>
 #include <sstream>
 
+const char* endpoint_end_reason_name(endpoint_end_reason reason) {
+  switch (reason) {
+    case EER_DISPOSE:
+      return "dispose";
+    case EER_UNREGISTER:
+      return "unregister";
+    case EER_PARTICIPANT_DISPOSE:
+      return "participant dispose";
+    case EER_LEASE_EXPIRY:
+      return "lease expiry";
+    case EER_NONE:
+    default:
+      return "none";
+  }
+}
+
 std::ostream& operator<<(std::ostream& os, const endpoint_info& info) {
-  return os << "( " << info.guid << ", " << info.src_net << ", " << info.dst_net_map << ", " << info.domain_id << ", " << info.first_evidence_frame << ", " << std::fixed << std::setprecision(3) << info.first_evidence_time << " )" << std::flush;
+  return os << "( " << info.guid << ", " << info.src_net << ", " << info.dst_net_map << ", " << info.domain_id << ", " << info.first_evidence_frame << ", " << std::fixed << std::setprecision(3) << info.first_evidence_time << " )";
 }
 
 bool merge_endpoint_info(endpoint_info& existing, const endpoint_info& update) {
@@ -27,7 +43,19 @@ bool merge_endpoint_info(endpoint_info& existing, const endpoint_info& update) {
     existing.domain_id = update.domain_id;
   }
 
+  if (update.first_evidence_frame > existing.last_evidence_frame) {
+    existing.last_evidence_frame = update.first_evidence_frame;
+    existing.last_evidence_time = update.first_evidence_time;
+  }
+  if (update.last_evidence_frame > existing.last_evidence_frame) {
+    existing.last_evidence_frame = update.last_evidence_frame;
+    existing.last_evidence_time = update.last_evidence_time;
+  }
+
   existing.reliable.merge(update.reliable);
+  if (update.qos.announced) {
+    existing.qos = update.qos;
+  }
 
   existing.spdp_announcements.insert(existing.spdp_announcements.end(), update.spdp_announcements.begin(), update.spdp_announcements.end());
   existing.sedp_announcements.insert(existing.sedp_announcements.end(), update.sedp_announcements.begin(), update.sedp_announcements.end());
@@ -35,6 +63,9 @@ bool merge_endpoint_info(endpoint_info& existing, const endpoint_info& update) {
   existing.gaps.insert(existing.gaps.end(), update.gaps.begin(), update.gaps.end());
   existing.heartbeats.insert(existing.heartbeats.end(), update.heartbeats.begin(), update.heartbeats.end());
   existing.acknacks.insert(existing.acknacks.end(), update.acknacks.begin(), update.acknacks.end());
+  existing.data_frags.insert(existing.data_frags.end(), update.data_frags.begin(), update.data_frags.end());
+  existing.heartbeat_frags.insert(existing.heartbeat_frags.end(), update.heartbeat_frags.begin(), update.heartbeat_frags.end());
+  existing.nack_frags.insert(existing.nack_frags.end(), update.nack_frags.begin(), update.nack_frags.end());
 
   if (existing.domain_id != update.domain_id && update.domain_id != 0xFF) {
     std::cout << "Contradictory endpoint data found while merging entries for GUID " << update.guid << std::endl;
@@ -50,7 +81,11 @@ bool create_or_merge_endpoint_info(const endpoint_info& info, endpoint_map& em)
   if (it != em.end()) {
     return merge_endpoint_info(it->second, info);
   } 
-    em[info.guid] = info;
+    endpoint_info& created = em[info.guid] = info;
+    if (created.last_evidence_frame < created.first_evidence_frame) {
+      created.last_evidence_frame = created.first_evidence_frame;
+      created.last_evidence_time = created.first_evidence_time;
+    }
     return true;
   
 }
@@ -66,6 +101,8 @@ void gather_participant_info(const std::map<size_t, rtps_frame>& frames, endpoin
         info.reliable = false;
         info.guid = frame.second.guid_prefix + dit->writer_id;
 
+        // PID_RTI_DOMAIN_ID when announced, otherwise the SPDP destination port
+        info.domain_id = dit->domain_id;
         if (info.domain_id == 0) {
           uint16_t port = 0;
           std::stringstream ss(frame.second.dst_port);
@@ -93,8 +130,11 @@ void gather_endpoint_info(const std::map<size_t, rtps_frame>& frames, endpoint_m
     for (auto dit = frame.second.data_vec.begin(); dit != frame.second.data_vec.end(); ++dit) {
       endpoint_info dataw_info(info);
       dataw_info.guid = frame.second.guid_prefix + dit->writer_id;
-      if (!dit->participant_guid.empty()) {
+      // Disposes and unregisters aren't announcements (they carry no QoS or locators); gather_endpoint_lifecycle handles them
+      bool announcement = !dit->disposed && !dit->unregistered;
+      if (!dit->participant_guid.empty() && announcement) {
         endpoint_info spdp_info;
+        spdp_info.domain_id = dataw_info.domain_id;
         for (size_t i = 0; i < dit->metatraffic_unicast_locator_ips.size(); ++i) {
           create_or_merge_net_info(net_info("", dit->metatraffic_unicast_locator_ips[i], dit->metatraffic_unicast_locator_ports[i]), spdp_info.dst_net_map);
         }
@@ -177,7 +217,7 @@ void gather_endpoint_info(const std::map<size_t, rtps_frame>& frames, endpoint_m
           create_or_merge_endpoint_info(spdp_info, em);
         }
       }
-      if (!dit->endpoint_guid.empty()) {
+      if (!dit->endpoint_guid.empty() && announcement) {
         endpoint_info sedp_info;
         sedp_info.guid = dit->endpoint_guid;
         for (size_t i = 0; i < dit->unicast_locator_ips.size(); ++i) {
@@ -191,6 +231,10 @@ void gather_endpoint_info(const std::map<size_t, rtps_frame>& frames, endpoint_m
         sedp_info.first_evidence_time = dataw_info.first_evidence_time;
         sedp_info.sedp_announcements.emplace_back(data_info_pair(&(frame.second), &(*dit)));
         sedp_info.reliable = dit->endpoint_reliability;
+        sedp_info.qos.announced = true;
+        sedp_info.qos.durability = dit->durability_kind;
+        sedp_info.qos.ownership = dit->ownership_kind;
+        sedp_info.qos.deadline = dit->deadline_period;
         if (dit->writer_id == "000003c2") {
           //std::cout << "writer announcment: " << sedp_info.guid << std::endl;
         } else if (dit->writer_id == "000004c2") {
@@ -283,6 +327,111 @@ void gather_endpoint_info(const std::map<size_t, rtps_frame>& frames, endpoint_m
       }
       create_or_merge_endpoint_info(anr_info, em);
     }
+    for (auto dfit = frame.second.data_frag_vec.begin(); dfit != frame.second.data_frag_vec.end(); ++dfit) {
+      endpoint_info dfw_info(info);
+      dfw_info.guid = frame.second.guid_prefix + dfit->writer_id;
+      std::vector<rtps_info_dst>::const_iterator idit;
+      if ((idit = find_previous_dst(frame.second, dfit->sm_order)) != frame.second.info_dst_vec.end() && dfit->reader_id != "00000000") {
+        endpoint_info dfr_info;
+        dfr_info.guid = idit->guid_prefix + dfit->reader_id;
+        create_or_merge_net_info(net_info(frame.second.dst_mac, frame.second.dst_ip, frame.second.dst_port), dfr_info.dst_net_map);
+        dfr_info.domain_id = dfw_info.domain_id;
+        dfr_info.first_evidence_frame = dfw_info.first_evidence_frame;
+        dfr_info.first_evidence_time = dfw_info.first_evidence_time;
+        create_or_merge_endpoint_info(dfr_info, em);
+      } else {
+        dfw_info.data_frags.emplace_back(df_info_pair(&(frame.second), &(*dfit)));
+      }
+      create_or_merge_endpoint_info(dfw_info, em);
+    }
+    for (auto hfit = frame.second.heartbeat_frag_vec.begin(); hfit != frame.second.heartbeat_frag_vec.end(); ++hfit) {
+      endpoint_info hbfw_info(info);
+      hbfw_info.guid = frame.second.guid_prefix + hfit->writer_id;
+      std::vector<rtps_info_dst>::const_iterator idit;
+      if ((idit = find_previous_dst(frame.second, hfit->sm_order)) != frame.second.info_dst_vec.end() && hfit->reader_id != "00000000") {
+        endpoint_info hbfr_info;
+        hbfr_info.guid = idit->guid_prefix + hfit->reader_id;
+        create_or_merge_net_info(net_info(frame.second.dst_mac, frame.second.dst_ip, frame.second.dst_port), hbfr_info.dst_net_map);
+        hbfr_info.domain_id = hbfw_info.domain_id;
+        hbfr_info.first_evidence_frame = hbfw_info.first_evidence_frame;
+        hbfr_info.first_evidence_time = hbfw_info.first_evidence_time;
+        create_or_merge_endpoint_info(hbfr_info, em);
+      } else {
+        hbfw_info.heartbeat_frags.emplace_back(hbf_info_pair(&(frame.second), &(*hfit)));
+      }
+      create_or_merge_endpoint_info(hbfw_info, em);
+    }
+    for (auto nfit = frame.second.nack_frag_vec.begin(); nfit != frame.second.nack_frag_vec.end(); ++nfit) {
+      endpoint_info nfr_info(info);
+      nfr_info.guid = frame.second.guid_prefix + nfit->reader_id; // nack_frag comes from reader side
+      nfr_info.reliable = true;
+      std::vector<rtps_info_dst>::const_iterator idit;
+      if ((idit = find_previous_dst(frame.second, nfit->sm_order)) != frame.second.info_dst_vec.end() && nfit->writer_id != "00000000") {
+        endpoint_info nfw_info;
+        nfw_info.guid = idit->guid_prefix + nfit->writer_id;
+        create_or_merge_net_info(net_info(frame.second.dst_mac, frame.second.dst_ip, frame.second.dst_port), nfw_info.dst_net_map);
+        nfw_info.domain_id = nfr_info.domain_id;
+        nfw_info.first_evidence_frame = nfr_info.first_evidence_frame;
+        nfw_info.first_evidence_time = nfr_info.first_evidence_time;
+        nfw_info.reliable = true;
+        create_or_merge_endpoint_info(nfw_info, em);
+      } else {
+        nfr_info.nack_frags.emplace_back(nf_info_pair(&(frame.second), &(*nfit)));
+      }
+      create_or_merge_endpoint_info(nfr_info, em);
+    }
   }
 }
 
+void gather_endpoint_lifecycle(const rtps_frame_map& frames, endpoint_map& em) {
+  std::map<std::string, std::pair<const rtps_frame*, endpoint_end_reason>> participant_ends;
+  std::map<std::string, double> lease_durations;
+  std::map<std::string, double> last_traffic;
+  double capture_end = 0.0;
+
+  for (const auto & it : frames) {
+    const rtps_frame& frame = it.second;
+    capture_end = std::max(capture_end, frame.frame_reference_time);
+    last_traffic[frame.guid_prefix] = frame.frame_reference_time;
+    for (const auto & data : frame.data_vec) {
+      bool ending = data.disposed || data.unregistered;
+      endpoint_end_reason reason = data.disposed ? EER_DISPOSE : EER_UNREGISTER;
+      if (data.writer_id == "000100c2" && !data.participant_guid.empty()) {
+        if (ending) {
+          participant_ends.emplace(data.participant_guid.substr(0, 24), std::make_pair(&frame, EER_PARTICIPANT_DISPOSE));
+        } else if (data.lease_duration > 0.0) {
+          lease_durations[data.participant_guid.substr(0, 24)] = data.lease_duration;
+        }
+      } else if ((data.writer_id == "000003c2" || data.writer_id == "000004c2") && !data.endpoint_guid.empty() && ending) {
+        auto eit = em.find(data.endpoint_guid);
+        if (eit != em.end() && eit->second.end_reason == EER_NONE) {
+          eit->second.end_evidence_frame = frame.frame_no;
+          eit->second.end_evidence_time = frame.frame_reference_time;
+          eit->second.end_reason = reason;
+        }
+      }
+    }
+  }
+
+  for (auto & it : em) {
+    endpoint_info& info = it.second;
+    std::string prefix = info.guid.substr(0, 24);
+    auto pit = participant_ends.find(prefix);
+    if (pit != participant_ends.end() && (info.end_reason == EER_NONE || pit->second.first->frame_reference_time < info.end_evidence_time)) {
+      info.end_evidence_frame = pit->second.first->frame_no;
+      info.end_evidence_time = pit->second.first->frame_reference_time;
+      info.end_reason = pit->second.second;
+    }
+    // Any message from a participant asserts its liveliness, so the lease runs from the participant's last frame
+    auto lit = lease_durations.find(prefix);
+    auto tit = last_traffic.find(prefix);
+    if (lit != lease_durations.end() && tit != last_traffic.end() && tit->second + lit->second < capture_end) {
+      double expiry = tit->second + lit->second;
+      if (info.end_reason == EER_NONE || expiry < info.end_evidence_time) {
+        info.end_evidence_frame = 0;
+        info.end_evidence_time = expiry;
+        info.end_reason = EER_LEASE_EXPIRY;
+      }
+    }
+  }
+}
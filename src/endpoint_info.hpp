@@ -9,6 +9,27 @@
 #include <string>
 #include <vector>
 
+enum endpoint_end_reason : uint8_t {
+  EER_NONE,
+  EER_DISPOSE,
+  EER_UNREGISTER,
+  EER_PARTICIPANT_DISPOSE,
+  EER_LEASE_EXPIRY
+};
+
+const char* endpoint_end_reason_name(endpoint_end_reason reason);
+
+// Topic index entry of endpoints whose SEDP announcement (with a topic name) wasn't captured
+const uint32_t NO_TOPIC = 0xFFFFFFFFu;
+
+// QoS announced via SEDP (reliability is tracked separately, since it can also be inferred from traffic)
+struct endpoint_qos {
+  bool announced{false};
+  uint8_t durability{0};
+  uint8_t ownership{0};
+  double deadline{-1.0};
+};
+
 struct endpoint_info {
   std::string guid;
   net_info src_net;
@@ -16,13 +37,24 @@ struct endpoint_info {
   size_t domain_id{0xFF};
   size_t first_evidence_frame{0};
   double first_evidence_time{-1.0};
+  size_t last_evidence_frame{0};
+  double last_evidence_time{-1.0};
+  size_t end_evidence_frame{0}; // 0 when the end was inferred (lease expiry) rather than observed
+  double end_evidence_time{-1.0};
+  endpoint_end_reason end_reason{EER_NONE};
   fuzzy_bool reliable;
+  endpoint_qos qos;
+  uint32_t topic_id{NO_TOPIC}; // assigned by gather_topic_index
+  uint32_t type_id{NO_TOPIC}; // index into topic_index::type_names, assigned along with topic_id
   std::vector<data_info_pair> spdp_announcements;
   std::vector<data_info_pair> sedp_announcements;
   std::vector<data_info_pair> datas;
   std::vector<gap_info_pair> gaps;
   std::vector<hb_info_pair> heartbeats;
   std::vector<an_info_pair> acknacks;
+  std::vector<df_info_pair> data_frags;
+  std::vector<hbf_info_pair> heartbeat_frags;
+  std::vector<nf_info_pair> nack_frags;
 };
 
 using endpoint_map = std::map<std::string, endpoint_info>;
@@ -34,3 +66,7 @@ bool create_or_merge_endpoint_info(const endpoint_info& info, endpoint_map& em);
 void gather_participant_info(const rtps_frame_map& frames, endpoint_map& em);
 void gather_endpoint_info(const rtps_frame_map& frames, endpoint_map& em);
 
+// Records end-of-life evidence: SEDP dispose / unregister of the endpoint itself, SPDP dispose / unregister of its
+// participant, or the participant's lease running out before the end of the capture (whichever comes first)
+void gather_endpoint_lifecycle(const rtps_frame_map& frames, endpoint_map& em);
+
@@ -0,0 +1,157 @@
+#include "expected_matches.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <limits>
+#include <iterator>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+namespace {
+
+const size_t guid_prefix_length = 24;
+
+// Both sides must name the same type, and offered (writer) QoS must be at least as strong as requested (reader) QoS;
+// unannounced QoS is assumed compatible
+bool endpoints_compatible(const endpoint_info& writer, const endpoint_info& reader) {
+  if (writer.type_id != reader.type_id) {
+    return false;
+  }
+  if (reader.reliable.is_known() && writer.reliable.is_known() && static_cast<bool>(reader.reliable) && !static_cast<bool>(writer.reliable)) {
+    return false;
+  }
+  if (!writer.qos.announced || !reader.qos.announced) {
+    return true;
+  }
+  double writer_deadline = writer.qos.deadline < 0.0 ? std::numeric_limits<double>::infinity() : writer.qos.deadline;
+  double reader_deadline = reader.qos.deadline < 0.0 ? std::numeric_limits<double>::infinity() : reader.qos.deadline;
+  return writer.qos.durability >= reader.qos.durability && writer.qos.ownership == reader.qos.ownership && writer_deadline <= reader_deadline;
+}
+
+double end_or(const endpoint_info& info, double end_time) {
+  return info.end_reason != EER_NONE ? info.end_evidence_time : end_time;
+}
+
+struct reader_entry {
+  const endpoint_info* info;
+  uint32_t participant_id;
+  uint32_t bit;
+};
+
+// Longest missing first; ties keep the order pairs were found in
+struct ranked_missing {
+  missing_match mm;
+  size_t order;
+};
+
+struct ranks_before {
+  bool operator()(const ranked_missing& a, const ranked_missing& b) const {
+    return a.mm.missing_for > b.mm.missing_for || (a.mm.missing_for == b.mm.missing_for && a.order < b.order);
+  }
+};
+
+}
+
+void gather_expected_matches(const topic_index& ti, const conversation_map& cm, uint16_t domain, double end_time, size_t worst_count, expected_match_info& emi) {
+  // Participants get dense ids once, so same-participant pairs are skipped on an integer compare
+  std::unordered_map<std::string, uint32_t> participant_ids;
+  auto participant_of = [&participant_ids](const endpoint_info& info) {
+    return participant_ids.emplace(info.guid.substr(0, guid_prefix_length), static_cast<uint32_t>(participant_ids.size())).first->second;
+  };
+
+  // Only the worst_count longest missing pairs are kept; the last of them is the shortest
+  std::set<ranked_missing, ranks_before> worst;
+  size_t found = 0;
+
+  for (const auto & topic : ti.topics) {
+    // Readers are bucketed by domain and numbered densely within the topic, so observed conversations become bits
+    std::unordered_map<std::string, uint32_t> reader_ids;
+    reader_ids.reserve(topic.readers.size());
+    std::map<size_t, std::vector<reader_entry>> readers_by_domain;
+    for (size_t i = 0; i < topic.readers.size(); ++i) {
+      const endpoint_info& reader = *topic.readers[i];
+      reader_ids.emplace(reader.guid, static_cast<uint32_t>(i));
+      readers_by_domain[reader.domain_id].push_back(reader_entry{&reader, participant_of(reader), static_cast<uint32_t>(i)});
+    }
+    std::vector<uint64_t> observed((topic.readers.size() + 63) / 64);
+
+    for (const endpoint_info* writer : topic.writers) {
+      if (domain != 0xFF && domain != writer->domain_id) {
+        continue;
+      }
+      auto dit = readers_by_domain.find(writer->domain_id);
+      if (dit == readers_by_domain.end()) {
+        continue;
+      }
+      uint32_t writer_participant = participant_of(*writer);
+      std::fill(observed.begin(), observed.end(), 0);
+      auto cit = cm.find(writer->guid);
+      if (cit != cm.end()) {
+        for (const auto & it : cit->second) {
+          auto rit = reader_ids.find(it.first);
+          if (rit != reader_ids.end()) {
+            observed[rit->second / 64] |= uint64_t(1) << (rit->second % 64);
+          }
+        }
+      }
+
+      for (const reader_entry& entry : dit->second) {
+        const endpoint_info& reader = *entry.info;
+        if (entry.participant_id == writer_participant) {
+          continue;
+        }
+        if (!endpoints_compatible(*writer, reader)) {
+          ++emi.incompatible_count;
+          continue;
+        }
+        ++emi.expected_count;
+        if ((observed[entry.bit / 64] & (uint64_t(1) << (entry.bit % 64))) != 0u) {
+          ++emi.observed_count;
+          continue;
+        }
+        // Only pairs whose lifetimes overlapped can be missing
+        double known_time = std::max(writer->first_evidence_time, reader.first_evidence_time);
+        double until = std::min(end_or(*writer, end_time), end_or(reader, end_time));
+        if (until <= known_time) {
+          --emi.expected_count;
+          continue;
+        }
+        ++emi.missing_count;
+        emi.missing_time.record(until - known_time);
+        ranked_missing rm{missing_match{writer, &reader, known_time, until - known_time}, found++};
+        if (worst.size() < worst_count || (!worst.empty() && ranks_before()(rm, *worst.rbegin()))) {
+          worst.insert(rm);
+          if (worst.size() > worst_count) {
+            worst.erase(std::prev(worst.end()));
+          }
+        }
+      }
+    }
+  }
+  emi.missing.clear();
+  emi.missing.reserve(worst.size());
+  for (const ranked_missing& rm : worst) {
+    emi.missing.push_back(rm.mm);
+  }
+}
+
+void print_expected_matches(std::ostream& os, const expected_match_info& emi, const topic_index& ti, bool show_histograms) {
+  os << "Expected Match Stats:" << std::endl;
+  os << " - Expected writer / reader pairs: " << emi.expected_count << " (observed: " << emi.observed_count << ", missing: " << emi.missing_count
+     << ", same topic but type or QoS incompatible: " << emi.incompatible_count << ")" << std::endl;
+  os << " - Time Missing (later endpoint announced to end of capture or of either endpoint):" << std::endl;
+  emi.missing_time.print_summary(os, "   ");
+  if (show_histograms) {
+    emi.missing_time.print_histogram(os, "     ");
+  }
+  if (emi.missing.empty()) {
+    return;
+  }
+  os << " - Longest Missing Pairs:" << std::endl;
+  for (const missing_match& mm : emi.missing) {
+    os << "   - " << mm.writer->guid << " >> " << mm.reader->guid << " [" << ti.topics[mm.writer->topic_id].name << "] missing for "
+       << std::fixed << std::setprecision(6) << mm.missing_for << " seconds since " << mm.known_time << std::endl;
+  }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "conversation_info.hpp"
+#include "endpoint_info.hpp"
+#include "hdr_histogram.hpp"
+#include "topics.hpp"
+
+#include <ostream>
+#include <vector>
+
+struct missing_match {
+  const endpoint_info* writer;
+  const endpoint_info* reader;
+  double known_time; // when the later of the two was announced
+  double missing_for; // from known_time until the end of the capture (or the earlier endpoint's end)
+};
+
+struct expected_match_info {
+  size_t expected_count{0};
+  size_t observed_count{0};
+  size_t incompatible_count{0}; // same topic and domain, but a different type or requested QoS not offered
+  size_t missing_count{0};
+  std::vector<missing_match> missing; // the longest missing, longest first
+  hdr_histogram missing_time;
+};
+
+// Each writer is compared only with its topic's readers in the same domain, on interned type ids, QoS fields and
+// participant ids; the conversations observed for the writer are marked in a bitset over the topic's readers. Pairs
+// within one participant are skipped since they needn't go over the wire. All missing pairs are counted, but only the
+// worst_count longest missing are kept.
+void gather_expected_matches(const topic_index& ti, const conversation_map& cm, uint16_t domain, double end_time, size_t worst_count, expected_match_info& emi);
+void print_expected_matches(std::ostream& os, const expected_match_info& emi, const topic_index& ti, bool show_histograms);
@@ -0,0 +1,418 @@
+#include "exporter.hpp"
+
+#include "utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+// Rows are formatted into the buffer until it holds about this much, then written out in one go
+const size_t flush_threshold = 1 << 20;
+
+const char* entity_kind_name(const std::string& guid) {
+  if (guid.size() < 2) {
+    return "unknown";
+  }
+  unsigned long kind = std::strtoul(guid.substr(guid.size() - 2).c_str(), nullptr, 16) & 0x3Fu;
+  switch (kind) {
+    case 0x01u:
+      return "participant";
+    case 0x02u:
+    case 0x03u:
+      return "writer";
+    case 0x04u:
+    case 0x07u:
+      return "reader";
+    default:
+      return "unknown";
+  }
+}
+
+record_writer& add_frame(record_writer& rw, size_t frame_no) {
+  return frame_no == 0 ? rw.add_null() : rw.add_uint(frame_no);
+}
+
+record_writer& add_time(record_writer& rw, double time) {
+  return time < 0.0 ? rw.add_null() : rw.add_double(time);
+}
+
+record_writer& add_topic(record_writer& rw, const topic_index& ti, uint32_t topic_id) {
+  return topic_id < ti.topics.size() ? rw.add_string(ti.topics[topic_id].name) : rw.add_null();
+}
+
+enum event_kind : uint8_t {
+  EK_DATA,
+  EK_GAP,
+  EK_HEARTBEAT,
+  EK_ACKNACK,
+  EK_DATA_FRAG,
+  EK_HEARTBEAT_FRAG,
+  EK_NACK_FRAG
+};
+
+const char* event_kind_name(event_kind kind) {
+  switch (kind) {
+    case EK_GAP:
+      return "gap";
+    case EK_HEARTBEAT:
+      return "heartbeat";
+    case EK_ACKNACK:
+      return "acknack";
+    case EK_DATA_FRAG:
+      return "data_frag";
+    case EK_HEARTBEAT_FRAG:
+      return "heartbeat_frag";
+    case EK_NACK_FRAG:
+      return "nack_frag";
+    case EK_DATA:
+    default:
+      return "data";
+  }
+}
+
+struct event_ref {
+  const rtps_frame* frame;
+  size_t sm_order;
+  event_kind kind;
+  size_t index;
+};
+
+template <typename T>
+void collect_events(const std::vector<std::pair<const rtps_frame*, const T*>>& pairs, event_kind kind, std::vector<event_ref>& events) {
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    events.push_back(event_ref{pairs[i].first, pairs[i].second->sm_order, kind, i});
+  }
+}
+
+// Columns shared by every event: everything up to and including the submessage flags
+template <typename T>
+void add_event_header(record_writer& rw, const conversation_info& conv, const event_ref& ev, const T& sm) {
+  const rtps_frame& frame = *ev.frame;
+  rw.add_string(conv.writer_guid).add_string(conv.reader_guid).add_uint(frame.frame_no).add_double(frame.frame_reference_time).add_uint(ev.sm_order)
+    .add_string(event_kind_name(ev.kind)).add_uint(sm.flags).add_string(frame.src_ip).add_string(frame.src_port).add_string(frame.dst_ip).add_string(frame.dst_port)
+    .add_uint(frame.udp_length);
+}
+
+}
+
+bool parse_export_format(const std::string& name, export_format& format) {
+  if (name == "jsonl") {
+    format = EF_JSONL;
+  } else if (name == "csv") {
+    format = EF_CSV;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+record_writer::record_writer(std::ostream& os, export_format fmt, const std::vector<const char*>& columns) : out(os), format(fmt), column_count(columns.size()) {
+  buffer.reserve(flush_threshold + 4096);
+  for (size_t i = 0; i < columns.size(); ++i) {
+    if (format == EF_JSONL) {
+      keys.push_back(std::string(i == 0 ? "{\"" : ",\"") + columns[i] + "\":");
+    } else {
+      buffer += (i == 0 ? "" : ",");
+      buffer += columns[i];
+    }
+  }
+  if (format == EF_CSV) {
+    buffer += '\n';
+  }
+}
+
+record_writer::~record_writer() {
+  flush();
+}
+
+void record_writer::begin_field() {
+  if (format == EF_JSONL) {
+    buffer += keys[column];
+  } else if (column != 0) {
+    buffer += ',';
+  }
+  ++column;
+}
+
+void record_writer::append_escaped(const std::string& value) {
+  if (format == EF_CSV) {
+    if (value.find_first_of(",\"\n\r") == std::string::npos) {
+      buffer += value;
+      return;
+    }
+    buffer += '"';
+    for (char c : value) {
+      buffer += c;
+      if (c == '"') {
+        buffer += '"';
+      }
+    }
+    buffer += '"';
+    return;
+  }
+  buffer += '"';
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        buffer += "\\\"";
+        break;
+      case '\\':
+        buffer += "\\\\";
+        break;
+      case '\n':
+        buffer += "\\n";
+        break;
+      case '\t':
+        buffer += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char esc[8];
+          std::snprintf(esc, sizeof(esc), "\\u%04x", static_cast<unsigned>(c));
+          buffer += esc;
+        } else {
+          buffer += c;
+        }
+    }
+  }
+  buffer += '"';
+}
+
+record_writer& record_writer::add_string(const std::string& value) {
+  begin_field();
+  append_escaped(value);
+  return *this;
+}
+
+record_writer& record_writer::add_uint(uint64_t value) {
+  begin_field();
+  char digits[20];
+  size_t n = 0;
+  do {
+    digits[n++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value != 0u);
+  while (n != 0u) {
+    buffer += digits[--n];
+  }
+  return *this;
+}
+
+record_writer& record_writer::add_double(double value) {
+  if (!std::isfinite(value)) {
+    return add_null();
+  }
+  begin_field();
+  // Fixed notation would need hundreds of digits for the largest doubles, so very large values switch to %.17g; the
+  // length is clamped anyway, since snprintf reports what it would have written
+  char text[64];
+  int n = std::snprintf(text, sizeof(text), std::fabs(value) < 1e15 ? "%.6f" : "%.17g", value);
+  buffer.append(text, std::min(static_cast<size_t>(std::max(n, 0)), sizeof(text) - 1));
+  return *this;
+}
+
+record_writer& record_writer::add_bool(bool value) {
+  begin_field();
+  buffer += (value ? "true" : "false");
+  return *this;
+}
+
+record_writer& record_writer::add_null() {
+  begin_field();
+  if (format == EF_JSONL) {
+    buffer += "null";
+  }
+  return *this;
+}
+
+void record_writer::end_row() {
+  // Rows that came up short are padded so every row keeps the full schema
+  while (column < column_count) {
+    add_null();
+  }
+  buffer += (format == EF_JSONL ? "}\n" : "\n");
+  column = 0;
+  ++rows;
+  if (buffer.size() >= flush_threshold) {
+    flush();
+  }
+}
+
+void record_writer::flush() {
+  out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+  buffer.clear();
+}
+
+size_t record_writer::row_count() const {
+  return rows;
+}
+
+size_t export_endpoints(std::ostream& os, export_format format, const endpoint_map& em, const topic_index& ti, uint16_t domain) {
+  record_writer rw(os, format, {"guid", "domain_id", "kind", "builtin", "src_ip", "src_port", "topic", "type", "reliable", "durability", "ownership", "deadline",
+    "first_evidence_frame", "first_evidence_time", "last_evidence_frame", "last_evidence_time", "end_reason", "end_evidence_frame", "end_evidence_time",
+    "spdp_announcements", "sedp_announcements", "datas", "gaps", "heartbeats", "acknacks", "data_frags", "heartbeat_frags", "nack_frags"});
+  for (const auto & it : em) {
+    const endpoint_info& info = it.second;
+    if (domain != 0xFF && domain != info.domain_id) {
+      continue;
+    }
+    rw.add_string(info.guid).add_uint(info.domain_id).add_string(entity_kind_name(info.guid)).add_bool(is_guid_builtin(info.guid))
+      .add_string(info.src_net.ip).add_string(info.src_net.port);
+    add_topic(rw, ti, info.topic_id);
+    if (info.type_id < ti.type_names.size()) {
+      rw.add_string(ti.type_names[info.type_id]);
+    } else {
+      rw.add_null();
+    }
+    if (info.reliable.is_known()) {
+      rw.add_bool(static_cast<bool>(info.reliable));
+    } else {
+      rw.add_null();
+    }
+    if (info.qos.announced) {
+      rw.add_uint(info.qos.durability).add_uint(info.qos.ownership);
+      add_time(rw, info.qos.deadline);
+    } else {
+      rw.add_null().add_null().add_null();
+    }
+    add_frame(rw, info.first_evidence_frame);
+    add_time(rw, info.first_evidence_time);
+    add_frame(rw, info.last_evidence_frame);
+    add_time(rw, info.last_evidence_time);
+    rw.add_string(endpoint_end_reason_name(info.end_reason));
+    add_frame(rw, info.end_evidence_frame);
+    add_time(rw, info.end_evidence_time);
+    rw.add_uint(info.spdp_announcements.size()).add_uint(info.sedp_announcements.size()).add_uint(info.datas.size()).add_uint(info.gaps.size())
+      .add_uint(info.heartbeats.size()).add_uint(info.acknacks.size()).add_uint(info.data_frags.size()).add_uint(info.heartbeat_frags.size())
+      .add_uint(info.nack_frags.size());
+    rw.end_row();
+  }
+  return rw.row_count();
+}
+
+size_t export_conversations(std::ostream& os, export_format format, const endpoint_map& em, const conversation_map& cm, const topic_index& ti, uint16_t domain) {
+  record_writer rw(os, format, {"writer_guid", "reader_guid", "domain_id", "topic", "builtin", "first_evidence_frame", "first_evidence_time", "discovery_time",
+    "last_evidence_frame", "last_evidence_time", "end_reason", "end_evidence_frame", "end_evidence_time",
+    "datas", "gaps", "heartbeats", "acknacks", "data_frags", "heartbeat_frags", "nack_frags"});
+  for (const auto & it : cm) {
+    auto wit = em.find(it.first);
+    for (const auto & it2 : it.second) {
+      const conversation_info& conv = it2.second;
+      if (domain != 0xFF && domain != conv.domain_id) {
+        continue;
+      }
+      auto rit = em.find(it2.first);
+      rw.add_string(conv.writer_guid).add_string(conv.reader_guid).add_uint(conv.domain_id);
+      add_topic(rw, ti, wit == em.end() ? NO_TOPIC : wit->second.topic_id);
+      rw.add_bool(is_guid_builtin(conv.writer_guid));
+      add_frame(rw, conv.first_evidence_frame);
+      add_time(rw, conv.first_evidence_time);
+      if (wit != em.end() && rit != em.end()) {
+        rw.add_double(conv.first_evidence_time - std::max(wit->second.first_evidence_time, rit->second.first_evidence_time));
+      } else {
+        rw.add_null();
+      }
+      add_frame(rw, conv.last_evidence_frame);
+      add_time(rw, conv.last_evidence_time);
+      rw.add_string(endpoint_end_reason_name(conv.end_reason));
+      add_frame(rw, conv.end_evidence_frame);
+      add_time(rw, conv.end_evidence_time);
+      rw.add_uint(conv.datas.size()).add_uint(conv.gaps.size()).add_uint(conv.heartbeats.size()).add_uint(conv.acknacks.size())
+        .add_uint(conv.data_frags.size()).add_uint(conv.heartbeat_frags.size()).add_uint(conv.nack_frags.size());
+      rw.end_row();
+    }
+  }
+  return rw.row_count();
+}
+
+size_t export_events(std::ostream& os, export_format format, const conversation_map& cm, uint16_t domain) {
+  record_writer rw(os, format, {"writer_guid", "reader_guid", "frame", "time", "sm_order", "kind", "flags", "src_ip", "src_port", "dst_ip", "dst_port", "udp_length",
+    "seq_num", "last_seq_num", "bitmap_base", "bitmap_count", "fragment_num", "fragment_count"});
+  std::vector<event_ref> events;
+  for (const auto & it : cm) {
+    for (const auto & it2 : it.second) {
+      const conversation_info& conv = it2.second;
+      if (domain != 0xFF && domain != conv.domain_id) {
+        continue;
+      }
+      events.clear();
+      collect_events(conv.datas, EK_DATA, events);
+      collect_events(conv.gaps, EK_GAP, events);
+      collect_events(conv.heartbeats, EK_HEARTBEAT, events);
+      collect_events(conv.acknacks, EK_ACKNACK, events);
+      collect_events(conv.data_frags, EK_DATA_FRAG, events);
+      collect_events(conv.heartbeat_frags, EK_HEARTBEAT_FRAG, events);
+      collect_events(conv.nack_frags, EK_NACK_FRAG, events);
+      std::sort(events.begin(), events.end(), [](const event_ref& a, const event_ref& b) {
+        return a.frame->frame_no != b.frame->frame_no ? a.frame->frame_no < b.frame->frame_no : a.sm_order < b.sm_order;
+      });
+
+      for (const auto & ev : events) {
+        switch (ev.kind) {
+          case EK_GAP: {
+            const rtps_gap& gap = *conv.gaps[ev.index].second;
+            add_event_header(rw, conv, ev, gap);
+            rw.add_uint(gap.gap_start).add_null().add_uint(gap.bitmap.base).add_uint(gap.bitmap.count());
+            break;
+          }
+          case EK_HEARTBEAT: {
+            const rtps_heartbeat& heartbeat = *conv.heartbeats[ev.index].second;
+            add_event_header(rw, conv, ev, heartbeat);
+            rw.add_uint(heartbeat.first_seq_num).add_uint(heartbeat.last_seq_num);
+            break;
+          }
+          case EK_ACKNACK: {
+            const rtps_acknack& acknack = *conv.acknacks[ev.index].second;
+            add_event_header(rw, conv, ev, acknack);
+            rw.add_null().add_null().add_uint(acknack.bitmap.base).add_uint(acknack.bitmap.count());
+            break;
+          }
+          case EK_DATA_FRAG: {
+            const rtps_data_frag& data_frag = *conv.data_frags[ev.index].second;
+            add_event_header(rw, conv, ev, data_frag);
+            rw.add_uint(data_frag.writer_seq_num).add_null().add_null().add_null().add_uint(data_frag.fragment_starting_num).add_uint(data_frag.fragments_in_submessage);
+            break;
+          }
+          case EK_HEARTBEAT_FRAG: {
+            const rtps_heartbeat_frag& heartbeat_frag = *conv.heartbeat_frags[ev.index].second;
+            add_event_header(rw, conv, ev, heartbeat_frag);
+            rw.add_uint(heartbeat_frag.writer_seq_num).add_null().add_null().add_null().add_uint(heartbeat_frag.last_fragment_num);
+            break;
+          }
+          case EK_NACK_FRAG: {
+            const rtps_nack_frag& nack_frag = *conv.nack_frags[ev.index].second;
+            add_event_header(rw, conv, ev, nack_frag);
+            rw.add_uint(nack_frag.writer_seq_num).add_null().add_uint(nack_frag.fragment_state.base).add_uint(nack_frag.fragment_state.count());
+            break;
+          }
+          case EK_DATA:
+          default: {
+            const rtps_data& data = *conv.datas[ev.index].second;
+            add_event_header(rw, conv, ev, data);
+            rw.add_uint(data.writer_seq_num);
+            break;
+          }
+        }
+        rw.end_row();
+      }
+    }
+  }
+  return rw.row_count();
+}
+
+size_t export_stats(std::ostream& os, export_format format, const std::vector<std::pair<std::string, const hdr_histogram*>>& stats) {
+  record_writer rw(os, format, {"name", "count", "min", "mean", "p50", "p90", "p99", "p999", "max"});
+  for (const auto & it : stats) {
+    const hdr_histogram& h = *it.second;
+    rw.add_string(it.first).add_uint(h.count());
+    if (h.count() != 0u) {
+      rw.add_double(h.min()).add_double(h.mean()).add_double(h.percentile(50.0)).add_double(h.percentile(90.0)).add_double(h.percentile(99.0))
+        .add_double(h.percentile(99.9)).add_double(h.max());
+    }
+    rw.end_row();
+  }
+  return rw.row_count();
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "conversation_info.hpp"
+#include "endpoint_info.hpp"
+#include "hdr_histogram.hpp"
+#include "topics.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum export_format : uint8_t {
+  EF_JSONL,
+  EF_CSV
+};
+
+// Returns false (leaving format alone) for names other than "jsonl" and "csv"
+bool parse_export_format(const std::string& name, export_format& format);
+
+// Writes rows with a fixed list of columns as JSON Lines (one object per row, keys in column order) or CSV (with a
+// header row). Rows are formatted into an in-memory buffer that is handed to the stream in large blocks, so the
+// stream is never flushed per field or per row. Values must be added in column order, followed by end_row().
+class record_writer {
+public:
+
+  record_writer(std::ostream& os, export_format format, const std::vector<const char*>& columns);
+  record_writer(const record_writer&) = delete;
+  record_writer& operator=(const record_writer&) = delete;
+  ~record_writer();
+
+  record_writer& add_string(const std::string& value);
+  record_writer& add_uint(uint64_t value);
+  record_writer& add_double(double value);
+  record_writer& add_bool(bool value);
+  record_writer& add_null(); // JSON null, empty CSV field
+  void end_row();
+
+  // Hands everything buffered so far to the stream (also done on destruction)
+  void flush();
+
+  size_t row_count() const;
+
+private:
+
+  void begin_field();
+  void append_escaped(const std::string& value);
+
+  std::ostream& out;
+  export_format format;
+  std::vector<std::string> keys; // JSON: the text preceding each value ("{\"name\":" or ",\"name\":")
+  size_t column_count;
+  size_t column{0};
+  size_t rows{0};
+  std::string buffer;
+};
+
+// Schemas (column lists) are fixed: new columns are only ever appended, so consumers can rely on names and positions.
+// Each function returns the number of rows written. Times are relative to the start of the capture, in seconds;
+// unknown values (no evidence, no announced QoS, unset sequence numbers) are written as null / empty fields.
+
+// One row per endpoint (participants included), with network, topic, QoS, evidence and per-submessage counts
+size_t export_endpoints(std::ostream& os, export_format format, const endpoint_map& em, const topic_index& ti, uint16_t domain);
+
+// One row per conversation, with evidence, discovery time and per-submessage counts
+size_t export_conversations(std::ostream& os, export_format format, const endpoint_map& em, const conversation_map& cm, const topic_index& ti, uint16_t domain);
+
+// One row per submessage attributed to a conversation, in frame / submessage order within each conversation
+size_t export_events(std::ostream& os, export_format format, const conversation_map& cm, uint16_t domain);
+
+// One row per named latency distribution (count, min, mean, percentiles and max, in seconds)
+size_t export_stats(std::ostream& os, export_format format, const std::vector<std::pair<std::string, const hdr_histogram*>>& stats);
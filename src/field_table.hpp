@@ -0,0 +1,134 @@
+#pragma once
+
+#include "frame_tree.hpp"
+
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+// Where a labelled field was found: its node in the frame tree (whose children hold a parameter's values) and the
+// offset within its line at which the value text starts
+struct field_cursor {
+  const frame_tree& tree;
+  size_t node;
+  size_t value_pos;
+
+  const std::string& line() const {
+    return tree.line(node);
+  }
+
+  const char* value() const {
+    return line().c_str() + value_pos;
+  }
+
+  // Value text of the first child whose label starts with label, or nullptr
+  const char* child_value(const char* label) const {
+    size_t child = tree.find_child(node, label);
+    return child == std::string::npos ? nullptr : tree.value(child);
+  }
+};
+
+enum field_match {
+  FM_NONE, // no descriptor's label is on the line
+  FM_LINE, // the line was parsed
+  FM_SUBTREE, // the line and everything below it were handled
+  FM_INVALID // a value parser rejected its value
+};
+
+// Parses the value of one labelled field into one member of T; parameters (subtree set) read their values from their
+// children, which are then skipped
+template <typename T, typename M>
+struct field_desc {
+  const char* label;
+  size_t label_length;
+  bool subtree;
+  M T::* member;
+  bool (*parse)(const field_cursor&, M&);
+
+  field_match apply(const field_cursor& c, T& out) const {
+    return !parse(c, out.*member) ? FM_INVALID : subtree ? FM_SUBTREE : FM_LINE;
+  }
+};
+
+// As field_desc, for values that fill a pair of members of T (e.g. a locator's address and port)
+template <typename T, typename M1, typename M2>
+struct field_pair_desc {
+  const char* label;
+  size_t label_length;
+  bool subtree;
+  M1 T::* first;
+  M2 T::* second;
+  bool (*parse)(const field_cursor&, M1&, M2&);
+
+  field_match apply(const field_cursor& c, T& out) const {
+    return !parse(c, out.*first, out.*second) ? FM_INVALID : subtree ? FM_SUBTREE : FM_LINE;
+  }
+};
+
+// Skips the subtree under any line carrying label (e.g. parameters nobody reads)
+template <typename T>
+struct skip_desc {
+  const char* label;
+  size_t label_length;
+
+  field_match apply(const field_cursor&, T&) const {
+    return FM_SUBTREE;
+  }
+};
+
+template <typename T, typename M, size_t N>
+constexpr field_desc<T, M> field(const char (&label)[N], M T::* member, bool (*parse)(const field_cursor&, M&)) {
+  return field_desc<T, M>{label, N - 1, false, member, parse};
+}
+
+template <typename T, typename M, size_t N>
+constexpr field_desc<T, M> parameter(const char (&label)[N], M T::* member, bool (*parse)(const field_cursor&, M&)) {
+  return field_desc<T, M>{label, N - 1, true, member, parse};
+}
+
+template <typename T, typename M1, typename M2, size_t N>
+constexpr field_pair_desc<T, M1, M2> parameter_pair(const char (&label)[N], M1 T::* first, M2 T::* second, bool (*parse)(const field_cursor&, M1&, M2&)) {
+  return field_pair_desc<T, M1, M2>{label, N - 1, true, first, second, parse};
+}
+
+template <typename T, size_t N>
+constexpr skip_desc<T> skip(const char (&label)[N]) {
+  return skip_desc<T>{label, N - 1};
+}
+
+namespace field_table_detail {
+
+template <size_t I, typename T, typename Fields>
+typename std::enable_if<(I == std::tuple_size<Fields>::value), field_match>::type
+apply_first_match(const Fields&, const frame_tree&, size_t, T&) {
+  return FM_NONE;
+}
+
+template <size_t I, typename T, typename Fields>
+typename std::enable_if<(I < std::tuple_size<Fields>::value), field_match>::type
+apply_first_match(const Fields& fields, const frame_tree& tree, size_t node, T& out) {
+  const auto& desc = std::get<I>(fields);
+  size_t pos = tree.line(node).find(desc.label, 0, desc.label_length);
+  if (pos != std::string::npos) {
+    return desc.apply(field_cursor{tree, node, pos + desc.label_length}, out);
+  }
+  return apply_first_match<I + 1>(fields, tree, node, out);
+}
+
+}
+
+// Runs the lines of a subtree through a constexpr tuple of field descriptors: a line is consumed by the first
+// descriptor whose label it contains, and the table is unrolled at compile time so each submessage kind gets its own
+// straight-line matcher. Subtrees consumed by parameter and skip descriptors are jumped over rather than scanned.
+// Returns false if any value parser rejected its value.
+template <typename T, typename Fields>
+bool parse_fields(const Fields& fields, const frame_tree& tree, size_t node, T& out) {
+  bool result = true;
+  for (size_t i = node; i < tree.end(node);) {
+    field_match match = field_table_detail::apply_first_match<0>(fields, tree, i, out);
+    result &= match != FM_INVALID;
+    i = match == FM_SUBTREE ? tree.end(i) : i + 1;
+  }
+  return result;
+}
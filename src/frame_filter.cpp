@@ -0,0 +1,63 @@
+#include "frame_filter.hpp"
+
+#include "utils.hpp"
+
+#include <sstream>
+
+namespace {
+
+const uint32_t PORT_BASE = 7400;
+const uint32_t DOMAIN_GAIN = 250;
+const uint32_t SPDP_MULTICAST_OFFSET = 0;
+const uint32_t USER_MULTICAST_OFFSET = 1;
+const std::string GUID_PREFIX_UNKNOWN = "000000000000000000000000";
+
+}
+
+void set_filter_guids(frame_filter& filter, const string_vec& guids) {
+  for (const auto & guid : guids) {
+    filter.guid_prefixes.insert(guid.substr(0, 24));
+  }
+}
+
+bool filter_accepts_time(const frame_filter& filter, const rtps_frame& frame) {
+  return frame.frame_reference_time >= filter.start_time && frame.frame_reference_time <= filter.end_time;
+}
+
+bool filter_accepts_port(const frame_filter& filter, const rtps_frame& frame) {
+  if (filter.domain == 0xFF || !is_ip_multicast(frame.dst_ip)) {
+    return true;
+  }
+  std::stringstream ss(frame.dst_port);
+  uint32_t port = 0;
+  ss >> port;
+  if (ss.fail() || port < PORT_BASE) {
+    return true;
+  }
+  uint32_t offset = (port - PORT_BASE) % DOMAIN_GAIN;
+  if (offset != SPDP_MULTICAST_OFFSET && offset != USER_MULTICAST_OFFSET) {
+    return true;
+  }
+  return (port - PORT_BASE) / DOMAIN_GAIN == filter.domain;
+}
+
+bool filter_accepts_guids(const frame_filter& filter, const rtps_frame& frame, const frame_tree& tree, const std::vector<size_t>& sm_nodes) {
+  if (filter.guid_prefixes.empty() || filter.guid_prefixes.count(frame.guid_prefix) != 0u) {
+    return true;
+  }
+  bool has_info_dst = false;
+  for (size_t sm_node : sm_nodes) {
+    if (tree.line(sm_node).find("INFO_DST") == std::string::npos) {
+      continue;
+    }
+    has_info_dst = true;
+    size_t prefix_node = tree.find_child(sm_node, "guidPrefix");
+    if (prefix_node != std::string::npos) {
+      std::string prefix = tree.value(prefix_node);
+      if (prefix == GUID_PREFIX_UNKNOWN || filter.guid_prefixes.count(prefix) != 0u) {
+        return true;
+      }
+    }
+  }
+  return !has_info_dst;
+}
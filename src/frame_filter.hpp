@@ -0,0 +1,33 @@
+#pragma once
+
+#include "common_types.hpp"
+#include "frame_tree.hpp"
+#include "frames.hpp"
+
+#include <limits>
+#include <set>
+#include <string>
+
+// Predicates applied while parsing (time, guid prefixes and well-known ports), so frames nobody asked about never reach
+// submessage parsing. The domain itself is only known once SPDP has been parsed: see filter_capture_domain.
+struct frame_filter {
+  uint16_t domain{0xFF}; // endpoint domain, filtered after parsing apart from filter_accepts_port
+  std::set<std::string> guid_prefixes; // participant guid prefixes (24 hex characters)
+  double start_time{-std::numeric_limits<double>::infinity()}; // frame reference time, inclusive
+  double end_time{std::numeric_limits<double>::infinity()}; // frame reference time, inclusive
+};
+
+// Accepts full guids or bare guid prefixes; only the participant prefix of each is kept
+void set_filter_guids(frame_filter& filter, const string_vec& guids);
+
+bool filter_accepts_time(const frame_filter& filter, const rtps_frame& frame);
+
+// Only multicast traffic to the SPDP / user multicast well-known ports (PB + DG * domain + d0 / d2) gives a reliable
+// domain, since unicast ports are often ephemeral. The domain tshark reports in the RTPS header is derived from the
+// port as well, so everything else is accepted here and left to the endpoint domain (PID_RTI_DOMAIN_ID or the SPDP
+// port) once the capture has been analyzed.
+bool filter_accepts_port(const frame_filter& filter, const rtps_frame& frame);
+
+// A frame is kept when it's sent by one of the tracked participants, addressed to one of them with INFO_DST,
+// or carries no INFO_DST at all (so the tracked participants could have received it)
+bool filter_accepts_guids(const frame_filter& filter, const rtps_frame& frame, const frame_tree& tree, const std::vector<size_t>& sm_nodes);
@@ -0,0 +1,62 @@
+#include "frame_tree.hpp"
+
+#include <cstring>
+
+bool frame_tree::label_starts_with(size_t i, const char* prefix) const {
+  size_t length = std::strlen(prefix);
+  return nodes[i].label_length >= length && line(i).compare(nodes[i].label_begin, length, prefix) == 0;
+}
+
+line_range frame_tree::subtree(size_t i) const {
+  return lines_between(i, nodes[i].end);
+}
+
+line_range frame_tree::lines_between(size_t first, size_t last) const {
+  return line_range{lines->begin() + static_cast<std::ptrdiff_t>(first), lines->begin() + static_cast<std::ptrdiff_t>(last)};
+}
+
+size_t frame_tree::find_child(size_t parent, const char* prefix) const {
+  for (size_t i = parent + 1; i < nodes[parent].end; i = nodes[i].end) {
+    if (label_starts_with(i, prefix)) {
+      return i;
+    }
+  }
+  return std::string::npos;
+}
+
+size_t frame_tree::find_in_subtree(size_t node, const char* text) const {
+  for (size_t i = node + 1; i < nodes[node].end; ++i) {
+    if (line(i).find(text) != std::string::npos) {
+      return i;
+    }
+  }
+  return std::string::npos;
+}
+
+void build_frame_tree(const string_vec& lines, frame_tree& tree) {
+  tree.lines = &lines;
+  tree.nodes.resize(lines.size());
+  std::vector<uint32_t> open;
+  for (size_t i = 0; i < lines.size(); ++i) {
+    const std::string& line = lines[i];
+    size_t indent = line.find_first_not_of(' ');
+    if (indent == std::string::npos) {
+      indent = 0; // blank lines close everything, like a new top-level node
+    }
+    size_t colon = line.find(": ", indent);
+    tree_node& node = tree.nodes[i];
+    node.depth = static_cast<uint32_t>(indent / 4);
+    node.label_begin = static_cast<uint32_t>(indent);
+    node.label_length = static_cast<uint32_t>((colon == std::string::npos ? line.size() : colon) - indent);
+    node.value_begin = static_cast<uint32_t>(colon == std::string::npos ? line.size() : colon + 2);
+
+    while (!open.empty() && tree.nodes[open.back()].depth >= node.depth) {
+      tree.nodes[open.back()].end = static_cast<uint32_t>(i);
+      open.pop_back();
+    }
+    open.push_back(static_cast<uint32_t>(i));
+  }
+  for (uint32_t i : open) {
+    tree.nodes[i].end = static_cast<uint32_t>(lines.size());
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "common_types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One line of a tshark verbose frame, placed by its indentation (four spaces per level)
+struct tree_node {
+  uint32_t end; // one past the last line of this node's subtree
+  uint32_t depth;
+  uint32_t label_begin; // first non-space character
+  uint32_t label_length; // up to the first ": ", or to the end of the line
+  uint32_t value_begin; // just past the first ": ", or the line length when there's no value
+};
+
+// Nodes are kept in line order, so node i's subtree is lines [i, end), its first child (if any) is i + 1 and its next
+// sibling is end; top-level nodes (the protocol layers) are found by starting at 0 and following end
+struct frame_tree {
+  const string_vec* lines{nullptr};
+  std::vector<tree_node> nodes;
+
+  const std::string& line(size_t i) const { return (*lines)[i]; }
+  const char* value(size_t i) const { return line(i).c_str() + nodes[i].value_begin; }
+  size_t end(size_t i) const { return nodes[i].end; }
+  bool label_starts_with(size_t i, const char* prefix) const;
+  line_range subtree(size_t i) const;
+  line_range lines_between(size_t first, size_t last) const;
+
+  // First child of parent whose label starts with prefix, or npos
+  size_t find_child(size_t parent, const char* prefix) const;
+  // First line below node that contains text, or npos
+  size_t find_in_subtree(size_t node, const char* text) const;
+};
+
+void build_frame_tree(const string_vec& lines, frame_tree& tree);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "common_types.hpp"
+#include "seq_num_set.hpp"
 
 #include <map>
 #include <string>
@@ -20,12 +21,15 @@ struct rtps_data {
   size_t writer_seq_num;
   bool unregistered;
   bool disposed;
+  std::string key_hash; // PID_KEY_HASH, if sent
+  uint32_t domain_id; // PID_RTI_DOMAIN_ID, 0 if not sent
   std::string participant_guid;
   string_vec metatraffic_unicast_locator_ips;
   string_vec metatraffic_unicast_locator_ports;
   string_vec metatraffic_multicast_locator_ips;
   string_vec metatraffic_multicast_locator_ports;
   uint32_t builtins;
+  double lease_duration; // seconds, negative if infinite or not announced
   std::string endpoint_guid;
   string_vec unicast_locator_ips;
   string_vec unicast_locator_ports;
@@ -33,6 +37,11 @@ struct rtps_data {
   string_vec multicast_locator_ports;
   string_vec registered_writers;
   bool endpoint_reliability;
+  std::string topic_name;
+  std::string type_name;
+  uint8_t durability_kind; // VOLATILE (0) to PERSISTENT (3)
+  uint8_t ownership_kind; // SHARED (0) or EXCLUSIVE (1)
+  double deadline_period; // seconds, negative if infinite or not announced
 };
 
 struct rtps_heartbeat {
@@ -49,8 +58,7 @@ struct rtps_acknack {
   uint16_t flags;
   std::string writer_id;
   std::string reader_id;
-  size_t bitmap_base;
-  std::string bitmap;
+  seq_num_set bitmap;
 };
 
 struct rtps_gap {
@@ -59,8 +67,37 @@ struct rtps_gap {
   std::string writer_id;
   std::string reader_id;
   size_t gap_start;
-  size_t bitmap_base;
-  std::string bitmap;
+  seq_num_set bitmap;
+};
+
+struct rtps_data_frag {
+  size_t sm_order;
+  uint16_t flags;
+  std::string writer_id;
+  std::string reader_id;
+  size_t writer_seq_num;
+  size_t fragment_starting_num;
+  size_t fragments_in_submessage;
+  size_t fragment_size;
+  size_t sample_size;
+};
+
+struct rtps_heartbeat_frag {
+  size_t sm_order;
+  uint16_t flags;
+  std::string writer_id;
+  std::string reader_id;
+  size_t writer_seq_num;
+  size_t last_fragment_num;
+};
+
+struct rtps_nack_frag {
+  size_t sm_order;
+  uint16_t flags;
+  std::string writer_id;
+  std::string reader_id;
+  size_t writer_seq_num;
+  seq_num_set fragment_state; // FragmentNumberSet shares the SequenceNumberSet layout
 };
 
 struct rtps_frame {
@@ -81,10 +118,12 @@ struct rtps_frame {
   std::vector<rtps_gap> gap_vec;
   std::vector<rtps_heartbeat> heartbeat_vec;
   std::vector<rtps_acknack> acknack_vec;
+  std::vector<rtps_data_frag> data_frag_vec;
+  std::vector<rtps_heartbeat_frag> heartbeat_frag_vec;
+  std::vector<rtps_nack_frag> nack_frag_vec;
 };
 
 using rtps_frame_map = std::map<size_t, rtps_frame>;
-using ip_frag_map = std::map<std::string, std::pair<std::pair<size_t, double>, size_t>>;
 
 std::vector<rtps_info_dst>::const_iterator find_previous_dst(const rtps_frame& frame, size_t sm_order_limit);
 
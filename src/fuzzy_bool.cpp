@@ -26,6 +26,10 @@ fuzzy_bool::operator bool() const {
   return fbv == FBV_TRUE;
 }
 
+bool fuzzy_bool::is_known() const {
+  return fbv != FBV_UNKNOWN;
+}
+
 fuzzy_bool& fuzzy_bool::merge(const fuzzy_bool& rhs) {
   if (&rhs != this) {
     if (fbv == FBV_UNKNOWN) {
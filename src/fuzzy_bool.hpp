@@ -16,6 +16,7 @@ public:
   fuzzy_bool& operator=(bool rhs);
 
   explicit operator bool() const;
+  bool is_known() const;
 
   fuzzy_bool& merge(const fuzzy_bool& rhs);
 
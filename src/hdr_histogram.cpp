@@ -0,0 +1,178 @@
+#include "hdr_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace {
+
+// Each power of two above SUB_BUCKET_COUNT ticks is split into SUB_BUCKET_HALF linear sub-buckets
+const uint64_t SUB_BUCKET_BITS = 7u;
+const uint64_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+const uint64_t SUB_BUCKET_HALF = SUB_BUCKET_COUNT >> 1u;
+const double MAX_TICKS = 4.0e18;
+const size_t BAR_WIDTH = 40;
+
+int highest_bit(uint64_t v) {
+  return 63 - __builtin_clzll(v);
+}
+
+}
+
+hdr_histogram::hdr_histogram(double res) : resolution(res > 0.0 ? res : 1e-6), total(0), low(0.0), high(0.0), sum(0.0), sum_sq(0.0) {}
+
+size_t hdr_histogram::bucket_index(uint64_t ticks) const {
+  if (ticks < SUB_BUCKET_COUNT) {
+    return static_cast<size_t>(ticks);
+  }
+  uint64_t shift = static_cast<uint64_t>(highest_bit(ticks)) - (SUB_BUCKET_BITS - 1u);
+  return static_cast<size_t>(SUB_BUCKET_COUNT + (shift - 1u) * SUB_BUCKET_HALF + ((ticks >> shift) - SUB_BUCKET_HALF));
+}
+
+uint64_t hdr_histogram::bucket_lowest(size_t index) const {
+  if (index < SUB_BUCKET_COUNT) {
+    return index;
+  }
+  uint64_t offset = index - SUB_BUCKET_COUNT;
+  uint64_t shift = offset / SUB_BUCKET_HALF + 1u;
+  return (offset % SUB_BUCKET_HALF + SUB_BUCKET_HALF) << shift;
+}
+
+uint64_t hdr_histogram::bucket_highest(size_t index) const {
+  if (index < SUB_BUCKET_COUNT) {
+    return index;
+  }
+  uint64_t shift = (index - SUB_BUCKET_COUNT) / SUB_BUCKET_HALF + 1u;
+  return bucket_lowest(index) + (uint64_t(1) << shift) - 1u;
+}
+
+void hdr_histogram::record(double value) {
+  double scaled = std::min(std::max(value / resolution, 0.0), MAX_TICKS);
+  size_t index = bucket_index(static_cast<uint64_t>(scaled));
+  if (index >= buckets.size()) {
+    buckets.resize(index + 1, 0);
+  }
+  ++buckets[index];
+
+  if (total == 0 || value < low) {
+    low = value;
+  }
+  if (total == 0 || value > high) {
+    high = value;
+  }
+  ++total;
+  sum += value;
+  sum_sq += value * value;
+}
+
+hdr_histogram& hdr_histogram::merge(const hdr_histogram& rhs) {
+  if (&rhs == this || rhs.total == 0) {
+    return *this;
+  }
+  if (rhs.resolution != resolution) {
+    // Different resolutions don't share bucket boundaries, so re-record using each bucket's lowest value
+    for (size_t i = 0; i < rhs.buckets.size(); ++i) {
+      for (uint64_t j = 0; j < rhs.buckets[i]; ++j) {
+        record(static_cast<double>(rhs.bucket_lowest(i)) * rhs.resolution);
+      }
+    }
+    return *this;
+  }
+  if (rhs.buckets.size() > buckets.size()) {
+    buckets.resize(rhs.buckets.size(), 0);
+  }
+  for (size_t i = 0; i < rhs.buckets.size(); ++i) {
+    buckets[i] += rhs.buckets[i];
+  }
+  low = total == 0 ? rhs.low : std::min(low, rhs.low);
+  high = total == 0 ? rhs.high : std::max(high, rhs.high);
+  total += rhs.total;
+  sum += rhs.sum;
+  sum_sq += rhs.sum_sq;
+  return *this;
+}
+
+size_t hdr_histogram::count() const {
+  return total;
+}
+
+double hdr_histogram::min() const {
+  return low;
+}
+
+double hdr_histogram::max() const {
+  return high;
+}
+
+double hdr_histogram::mean() const {
+  return total == 0 ? 0.0 : sum / static_cast<double>(total);
+}
+
+double hdr_histogram::stddev() const {
+  if (total < 2) {
+    return 0.0;
+  }
+  double m = mean();
+  double var = sum_sq / static_cast<double>(total) - m * m;
+  return var > 0.0 ? std::sqrt(var) : 0.0;
+}
+
+double hdr_histogram::percentile(double pct) const {
+  if (total == 0) {
+    return 0.0;
+  }
+  // Nearest-rank: the smallest value such that at least pct percent of the samples are <= it
+  double exact_rank = std::ceil(std::min(std::max(pct, 0.0), 100.0) / 100.0 * static_cast<double>(total));
+  uint64_t rank = std::max(static_cast<uint64_t>(exact_rank), uint64_t(1));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      double value = static_cast<double>(bucket_highest(i)) * resolution;
+      return std::min(std::max(value, low), high);
+    }
+  }
+  return high;
+}
+
+std::ostream& hdr_histogram::print_summary(std::ostream& os, const std::string& indent, const std::string& note) const {
+  os << indent << "- Count:  " << total << '\n';
+  os << std::fixed << std::setprecision(6);
+  os << indent << "- Min:    " << std::setw(8) << min() << '\n';
+  os << indent << "- Mean:   " << std::setw(8) << mean() << '\n';
+  os << indent << "- P50:    " << std::setw(8) << percentile(50.0) << '\n';
+  os << indent << "- P90:    " << std::setw(8) << percentile(90.0) << '\n';
+  os << indent << "- P99:    " << std::setw(8) << percentile(99.0) << '\n';
+  os << indent << "- P99.9:  " << std::setw(8) << percentile(99.9) << '\n';
+  return os << indent << "- Max:    " << std::setw(8) << max() << note << std::endl;
+}
+
+std::ostream& hdr_histogram::print_histogram(std::ostream& os, const std::string& indent) const {
+  // Group 0 holds zero ticks, group g holds [2^(g-1), 2^g) ticks
+  std::vector<uint64_t> groups(65, 0);
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    uint64_t lowest = bucket_lowest(i);
+    groups[lowest == 0 ? 0 : static_cast<size_t>(highest_bit(lowest)) + 1] += buckets[i];
+  }
+  auto first = std::find_if(groups.begin(), groups.end(), [](uint64_t v) { return v != 0; });
+  if (first == groups.end()) {
+    return os;
+  }
+  auto last = std::find_if(groups.rbegin(), groups.rend(), [](uint64_t v) { return v != 0; }).base();
+  uint64_t peak = *std::max_element(first, last);
+
+  os << std::fixed << std::setprecision(6);
+  for (auto it = first; it != last; ++it) {
+    auto g = static_cast<size_t>(it - groups.begin());
+    double lo = g == 0 ? 0.0 : std::ldexp(resolution, static_cast<int>(g) - 1);
+    double hi = std::ldexp(resolution, static_cast<int>(g));
+    auto bar = static_cast<size_t>(static_cast<double>(BAR_WIDTH) * static_cast<double>(*it) / static_cast<double>(peak) + 0.5);
+    os << indent << "[" << std::setw(12) << lo << ", " << std::setw(12) << hi << ") " << std::setw(10) << *it;
+    if (bar != 0) {
+      os << " " << std::string(bar, '#');
+    }
+    os << '\n';
+  }
+  return os << std::flush;
+}
+
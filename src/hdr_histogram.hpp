@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Log-linear ("HDR") histogram for non-negative durations measured in seconds.
+// Values are bucketed with a relative error of at most 1/64 above the chosen
+// resolution, so memory use depends on the range of the values recorded rather
+// than the number of samples. Count, min, max and mean are tracked exactly.
+class hdr_histogram {
+public:
+
+  explicit hdr_histogram(double res = 1e-6);
+
+  void record(double value);
+  hdr_histogram& merge(const hdr_histogram& rhs);
+
+  size_t count() const;
+  double min() const;
+  double max() const;
+  double mean() const;
+  double stddev() const;
+  double percentile(double pct) const;
+
+  // Prints count, min, mean, p50, p90, p99, p99.9 and max (one per line), appending note to the max line
+  std::ostream& print_summary(std::ostream& os, const std::string& indent, const std::string& note = std::string()) const;
+
+  // Prints one line per power-of-two bucket between the smallest and largest recorded values
+  std::ostream& print_histogram(std::ostream& os, const std::string& indent) const;
+
+private:
+
+  size_t bucket_index(uint64_t ticks) const;
+  uint64_t bucket_lowest(size_t index) const;
+  uint64_t bucket_highest(size_t index) const;
+
+  double resolution;
+  std::vector<uint64_t> buckets;
+  size_t total;
+  double low;
+  double high;
+  double sum;
+  double sum_sq;
+};
+
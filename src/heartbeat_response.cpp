@@ -0,0 +1,134 @@
+#include "heartbeat_response.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+namespace {
+
+template <typename T>
+bool frame_order(const std::pair<const rtps_frame*, const T*>& a, const std::pair<const rtps_frame*, const T*>& b) {
+  return a.first->frame_no < b.first->frame_no || (a.first->frame_no == b.first->frame_no && a.second->sm_order < b.second->sm_order);
+}
+
+bool is_final(const rtps_heartbeat& hb) {
+  return (hb.flags & 0x02u) != 0u;
+}
+
+double percent(size_t part, size_t whole) {
+  return whole == 0 ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(whole);
+}
+
+}
+
+void gather_heartbeat_response_info(const conversation_map& cm, uint16_t domain, heartbeat_response_map& hrm) {
+  for (const auto & it : cm) {
+    for (const auto & it2 : it.second) {
+      const conversation_info& conv = it2.second;
+      if ((domain != 0xFF && domain != conv.domain_id) || conv.heartbeats.empty()) {
+        continue;
+      }
+      heartbeat_response_info& info = hrm[conv.writer_guid][conv.reader_guid];
+      info.writer_guid = conv.writer_guid;
+      info.reader_guid = conv.reader_guid;
+      info.domain_id = conv.domain_id;
+
+      std::vector<hb_info_pair> heartbeats(conv.heartbeats);
+      std::vector<an_info_pair> acknacks(conv.acknacks);
+      std::sort(heartbeats.begin(), heartbeats.end(), frame_order<rtps_heartbeat>);
+      std::sort(acknacks.begin(), acknacks.end(), frame_order<rtps_acknack>);
+
+      std::vector<hb_info_pair> requests;
+      for (size_t i = 0; i < heartbeats.size(); ++i) {
+        if (i != 0) {
+          info.periods.record(heartbeats[i].first->frame_reference_time - heartbeats[i - 1].first->frame_reference_time);
+        }
+        if (is_final(*heartbeats[i].second)) {
+          ++info.final_count;
+        } else {
+          requests.push_back(heartbeats[i]);
+        }
+      }
+      info.heartbeat_count = heartbeats.size();
+
+      // Both lists are in capture order, so a single forward scan of the acknacks covers every heartbeat
+      auto ait = acknacks.begin();
+      for (size_t i = 0; i < requests.size(); ++i) {
+        size_t hb_frame = requests[i].first->frame_no;
+        while (ait != acknacks.end() && ait->first->frame_no <= hb_frame) {
+          ++ait;
+        }
+        if (ait != acknacks.end() && (i + 1 == requests.size() || ait->first->frame_no < requests[i + 1].first->frame_no)) {
+          info.response_times.record(ait->first->frame_reference_time - requests[i].first->frame_reference_time);
+          ++info.answered_count;
+        } else {
+          ++info.unanswered_count;
+        }
+      }
+    }
+  }
+}
+
+void print_heartbeat_response_stats(std::ostream& os, const heartbeat_response_map& hrm, size_t worst_count, bool show_histograms) {
+  hdr_histogram all_response_times;
+  size_t heartbeat_count = 0;
+  size_t final_count = 0;
+  size_t unanswered_count = 0;
+  std::map<std::string, hdr_histogram> writer_periods;
+  std::vector<const heartbeat_response_info*> ranked;
+
+  for (const auto & it : hrm) {
+    hdr_histogram& periods = writer_periods[it.first];
+    for (const auto & it2 : it.second) {
+      const heartbeat_response_info& info = it2.second;
+      all_response_times.merge(info.response_times);
+      heartbeat_count += info.heartbeat_count;
+      final_count += info.final_count;
+      unanswered_count += info.unanswered_count;
+      periods.merge(info.periods);
+      ranked.push_back(&info);
+    }
+  }
+
+  size_t request_count = heartbeat_count - final_count;
+  os << "Heartbeat Response Stats:" << std::endl;
+  os << " - Conversations with heartbeats: " << ranked.size() << std::endl;
+  os << " - Heartbeats: " << heartbeat_count << " (final: " << final_count << ")" << std::endl;
+  os << " - Unanswered heartbeats: " << unanswered_count << " of " << request_count << " (" << std::fixed << std::setprecision(2) << percent(unanswered_count, request_count) << "%)" << std::endl;
+  os << " - Heartbeat to Acknack Response Times:" << std::endl;
+  all_response_times.print_summary(os, "   ");
+  if (show_histograms) {
+    all_response_times.print_histogram(os, "     ");
+  }
+
+  os << " - Heartbeat Period / Jitter by Writer:" << std::endl;
+  for (const auto & it : writer_periods) {
+    if (it.second.count() != 0) {
+      os << "   - " << it.first << " :: intervals = " << it.second.count() << std::fixed << std::setprecision(6)
+         << ", mean period = " << it.second.mean() << ", jitter = " << it.second.stddev() << ", p99 period = " << it.second.percentile(99.0) << '\n';
+    }
+  }
+
+  // A reader that never answers has no response times at all, so the unanswered share ranks first and p99 breaks ties
+  auto worse = [](const heartbeat_response_info* a, const heartbeat_response_info* b) {
+    double a_unanswered = percent(a->unanswered_count, a->heartbeat_count - a->final_count);
+    double b_unanswered = percent(b->unanswered_count, b->heartbeat_count - b->final_count);
+    if (a_unanswered != b_unanswered) {
+      return a_unanswered > b_unanswered;
+    }
+    return a->response_times.percentile(99.0) > b->response_times.percentile(99.0);
+  };
+  size_t shown = std::min(worst_count, ranked.size());
+  std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(shown), ranked.end(), worse);
+
+  os << " - Slowest Conversations (by unanswered share, then p99 response time):" << std::endl;
+  for (size_t i = 0; i < shown; ++i) {
+    const heartbeat_response_info& info = *ranked[i];
+    os << "   - " << info.writer_guid << " >> " << info.reader_guid << " :: heartbeats = " << info.heartbeat_count
+       << ", unanswered = " << info.unanswered_count << " (" << std::fixed << std::setprecision(2) << percent(info.unanswered_count, info.heartbeat_count - info.final_count) << "%)"
+       << std::setprecision(6) << ", p50 = " << info.response_times.percentile(50.0) << ", p99 = " << info.response_times.percentile(99.0)
+       << ", max = " << info.response_times.max() << '\n';
+  }
+  os << std::flush;
+}
+
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "conversation_info.hpp"
+#include "hdr_histogram.hpp"
+
+#include <map>
+#include <ostream>
+#include <string>
+
+struct heartbeat_response_info {
+  std::string writer_guid;
+  std::string reader_guid;
+  uint16_t domain_id{0xFF};
+  size_t heartbeat_count{0};
+  size_t final_count{0};
+  size_t answered_count{0};
+  size_t unanswered_count{0};
+  hdr_histogram response_times;
+  hdr_histogram periods;
+};
+
+using heartbeat_response_map = std::map<std::string, std::map<std::string, heartbeat_response_info>>;
+
+// Matches each non-final HEARTBEAT a writer sends to a reader with the first ACKNACK the reader sends back before the writer's next non-final HEARTBEAT
+void gather_heartbeat_response_info(const conversation_map& cm, uint16_t domain, heartbeat_response_map& hrm);
+void print_heartbeat_response_stats(std::ostream& os, const heartbeat_response_map& hrm, size_t worst_count, bool show_histograms);
+
@@ -22,12 +22,12 @@ std::ostream& data_info_pair_printer::print(std::ostream& os) const {
   os << " - " + data_type << " in frame" << std::string(10 - data_type.size(), ' ')
     << std::setw(6) << frame.frame_no << " at time " << std::setw(7) << std::fixed << std::setprecision(3) << frame.frame_reference_time
     << " sent to " << display_guid << " @ " << frame.dst_ip << ":" << frame.dst_port
-    << " :: flags = " << flagstr << ", length = " << frame.udp_length << ", seq_num = " << data.writer_seq_num << std::flush;
+    << " :: flags = " << flagstr << ", length = " << frame.udp_length << ", seq_num = " << data.writer_seq_num;
   if (!data.participant_guid.empty()) {
-    os << ", participant_guid = " << data.participant_guid << std::flush;
+    os << ", participant_guid = " << data.participant_guid;
   }
   if (!data.endpoint_guid.empty()) {
-    os << ", endpoint_guid = " << data.endpoint_guid << std::flush;
+    os << ", endpoint_guid = " << data.endpoint_guid;
   }
   return os;
 }
@@ -42,7 +42,7 @@ std::ostream& gap_info_pair_printer::print(std::ostream& os) const {
   std::string flagstr = std::string("---") + check_flag_string(gap.flags, "E");
   return os << " - Gap in frame       " << std::setw(6) << frame.frame_no << " at time " << std::setw(7) << std::fixed << std::setprecision(3) << frame.frame_reference_time
     << " sent to " << display_guid << " @ " << frame.dst_ip << ":" << frame.dst_port
-    << " :: flags = " << flagstr << ", start = " << gap.gap_start << ", base = " << gap.bitmap_base << ", bitmap = " << gap.bitmap  << std::flush;
+    << " :: flags = " << flagstr << ", start = " << gap.gap_start << ", base = " << gap.bitmap.base << ", bitmap = " << gap.bitmap ;
 }
 
 hb_info_pair_printer::hb_info_pair_printer(const hb_info_pair& p) : pair(p) {}
@@ -55,7 +55,7 @@ std::ostream& hb_info_pair_printer::print(std::ostream& os) const {
   std::string flagstr = std::string("-") + check_flag_string(heartbeat.flags, "LFE");
   return os << " - Heartbeat in frame " << std::setw(6) << frame.frame_no << " at time " << std::setw(7) << std::fixed << std::setprecision(3) << frame.frame_reference_time
     << " sent to " << display_guid << " @ " << frame.dst_ip << ":" << frame.dst_port
-    << " :: flags = " << flagstr << ", first = " << heartbeat.first_seq_num << ", last = " << heartbeat.last_seq_num << std::flush;
+    << " :: flags = " << flagstr << ", first = " << heartbeat.first_seq_num << ", last = " << heartbeat.last_seq_num;
 }
 
 an_info_pair_printer::an_info_pair_printer(const an_info_pair& p) : pair(p) {}
@@ -68,6 +68,45 @@ std::ostream& an_info_pair_printer::print(std::ostream& os) const {
   std::string flagstr = std::string("--") + check_flag_string(acknack.flags, "FE");
   return os << " - Acknack in frame   " << std::setw(6) << frame.frame_no << " at time " << std::setw(7) << std::fixed << std::setprecision(3) << frame.frame_reference_time
     << " sent to " << display_guid << " @ " << frame.dst_ip << ":" << frame.dst_port
-    << " :: flags = " << flagstr << ", base = " << acknack.bitmap_base << ", bitmap = " << acknack.bitmap  << std::flush;
+    << " :: flags = " << flagstr << ", base = " << acknack.bitmap.base << ", bitmap = " << acknack.bitmap ;
 }
 
+df_info_pair_printer::df_info_pair_printer(const df_info_pair& p) : pair(p) {}
+
+std::ostream& df_info_pair_printer::print(std::ostream& os) const {
+  const auto& frame = *(pair.first);
+  const auto& data_frag = *(pair.second);
+  auto idit = find_previous_dst(frame, data_frag.sm_order);
+  std::string display_guid = (idit == frame.info_dst_vec.end() ? std::string("????????????????????????") : idit->guid_prefix) + data_frag.reader_id;
+  std::string flagstr = std::string("-") + check_flag_string(data_frag.flags, "KQE");
+  return os << " - DataFrag in frame  " << std::setw(6) << frame.frame_no << " at time " << std::setw(7) << std::fixed << std::setprecision(3) << frame.frame_reference_time
+    << " sent to " << display_guid << " @ " << frame.dst_ip << ":" << frame.dst_port
+    << " :: flags = " << flagstr << ", length = " << frame.udp_length << ", seq_num = " << data_frag.writer_seq_num
+    << ", fragments = " << data_frag.fragment_starting_num << "+" << data_frag.fragments_in_submessage << ", sample_size = " << data_frag.sample_size;
+}
+
+hbf_info_pair_printer::hbf_info_pair_printer(const hbf_info_pair& p) : pair(p) {}
+
+std::ostream& hbf_info_pair_printer::print(std::ostream& os) const {
+  const auto& frame = *(pair.first);
+  const auto& heartbeat_frag = *(pair.second);
+  auto idit = find_previous_dst(frame, heartbeat_frag.sm_order);
+  std::string display_guid = (idit == frame.info_dst_vec.end() ? std::string("????????????????????????") : idit->guid_prefix) + heartbeat_frag.reader_id;
+  std::string flagstr = std::string("---") + check_flag_string(heartbeat_frag.flags, "E");
+  return os << " - HbFrag in frame    " << std::setw(6) << frame.frame_no << " at time " << std::setw(7) << std::fixed << std::setprecision(3) << frame.frame_reference_time
+    << " sent to " << display_guid << " @ " << frame.dst_ip << ":" << frame.dst_port
+    << " :: flags = " << flagstr << ", seq_num = " << heartbeat_frag.writer_seq_num << ", last_fragment = " << heartbeat_frag.last_fragment_num;
+}
+
+nf_info_pair_printer::nf_info_pair_printer(const nf_info_pair& p) : pair(p) {}
+
+std::ostream& nf_info_pair_printer::print(std::ostream& os) const {
+  const auto& frame = *(pair.first);
+  const auto& nack_frag = *(pair.second);
+  auto idit = find_previous_dst(frame, nack_frag.sm_order);
+  std::string display_guid = (idit == frame.info_dst_vec.end() ? std::string("????????????????????????") : idit->guid_prefix) + nack_frag.writer_id;
+  std::string flagstr = std::string("---") + check_flag_string(nack_frag.flags, "E");
+  return os << " - NackFrag in frame  " << std::setw(6) << frame.frame_no << " at time " << std::setw(7) << std::fixed << std::setprecision(3) << frame.frame_reference_time
+    << " sent to " << display_guid << " @ " << frame.dst_ip << ":" << frame.dst_port
+    << " :: flags = " << flagstr << ", seq_num = " << nack_frag.writer_seq_num << ", base = " << nack_frag.fragment_state.base << ", bitmap = " << nack_frag.fragment_state;
+}
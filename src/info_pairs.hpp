@@ -9,6 +9,9 @@ using data_info_pair = std::pair<const rtps_frame*, const rtps_data*>;
 using gap_info_pair = std::pair<const rtps_frame*, const rtps_gap*>;
 using hb_info_pair = std::pair<const rtps_frame*, const rtps_heartbeat*>;
 using an_info_pair = std::pair<const rtps_frame*, const rtps_acknack*>;
+using df_info_pair = std::pair<const rtps_frame*, const rtps_data_frag*>;
+using hbf_info_pair = std::pair<const rtps_frame*, const rtps_heartbeat_frag*>;
+using nf_info_pair = std::pair<const rtps_frame*, const rtps_nack_frag*>;
 
 struct info_pair_printer_base {
   info_pair_printer_base() = default;
@@ -44,4 +47,21 @@ struct an_info_pair_printer : public info_pair_printer_base {
   std::ostream& print(std::ostream& os) const override;
 };
 
+struct df_info_pair_printer : public info_pair_printer_base {
+  explicit df_info_pair_printer(const df_info_pair& p);
+  const df_info_pair& pair;
+  std::ostream& print(std::ostream& os) const override;
+};
+
+struct hbf_info_pair_printer : public info_pair_printer_base {
+  explicit hbf_info_pair_printer(const hbf_info_pair& p);
+  const hbf_info_pair& pair;
+  std::ostream& print(std::ostream& os) const override;
+};
+
+struct nf_info_pair_printer : public info_pair_printer_base {
+  explicit nf_info_pair_printer(const nf_info_pair& p);
+  const nf_info_pair& pair;
+  std::ostream& print(std::ostream& os) const override;
+};
 
@@ -0,0 +1,177 @@
+#include "ip_fragments.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+bool parse_ipv4(const std::string& ip, uint32_t& out) {
+  std::stringstream ss(ip);
+  out = 0;
+  for (int i = 0; i < 4; ++i) {
+    unsigned octet = 256;
+    char dot = '.';
+    if (i != 0) {
+      ss >> dot;
+    }
+    ss >> octet;
+    if (ss.fail() || dot != '.' || octet > 255) {
+      return false;
+    }
+    out = (out << 8u) | octet;
+  }
+  return ss.peek() == std::char_traits<char>::eof();
+}
+
+void expire(double now, ip_fragment_tracker& ift) {
+  while (!ift.expiry.empty() && ift.expiry.front().second + ip_fragment_tracker::IP_FRAGMENT_TIMEOUT < now) {
+    auto it = ift.pending.find(ift.expiry.front().first);
+    // Completed datagrams leave their expiry entry behind, so only evict if the entry still belongs to this datagram
+    if (it != ift.pending.end() && it->second.first_time == ift.expiry.front().second) {
+      it->second.timed_out = true;
+      ift.finished.push_back(std::move(it->second));
+      ift.pending.erase(it);
+    }
+    ift.expiry.pop_front();
+  }
+}
+
+void print_group_stats(std::ostream& os, const std::string& title, const std::map<std::string, ip_fragment_group_stats>& groups, size_t worst_count) {
+  std::vector<const std::pair<const std::string, ip_fragment_group_stats>*> ranked;
+  for (const auto & it : groups) {
+    ranked.push_back(&it);
+  }
+  size_t shown = std::min(worst_count, ranked.size());
+  std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(shown), ranked.end(), [](const auto* a, const auto* b) {
+    double ap99 = a->second.reconstruction_times.percentile(99.0);
+    double bp99 = b->second.reconstruction_times.percentile(99.0);
+    if (ap99 != bp99) {
+      return ap99 > bp99;
+    }
+    return a->second.incomplete_count > b->second.incomplete_count;
+  });
+  os << " - " << title << ":" << std::endl;
+  for (size_t i = 0; i < shown; ++i) {
+    const ip_fragment_group_stats& g = ranked[i]->second;
+    os << "   - " << ranked[i]->first << " :: datagrams = " << g.datagram_count << ", incomplete = " << g.incomplete_count
+       << std::fixed << std::setprecision(6) << ", p50 = " << g.reconstruction_times.percentile(50.0) << ", p99 = " << g.reconstruction_times.percentile(99.0)
+       << ", max = " << g.reconstruction_times.max() << '\n';
+  }
+}
+
+}
+
+bool operator==(const ip_fragment_key& a, const ip_fragment_key& b) {
+  return a.src == b.src && a.dst == b.dst && a.id == b.id && a.protocol == b.protocol;
+}
+
+size_t ip_fragment_key_hash::operator()(const ip_fragment_key& key) const noexcept {
+  uint64_t v = (uint64_t(key.src) << 32u) ^ key.dst ^ (uint64_t(key.id) << 16u) ^ (uint64_t(key.protocol) << 56u);
+  v = (v ^ (v >> 33u)) * 0xff51afd7ed558ccdull;
+  v = (v ^ (v >> 33u)) * 0xc4ceb9fe1a85ec53ull;
+  return static_cast<size_t>(v ^ (v >> 33u));
+}
+
+constexpr double ip_fragment_tracker::IP_FRAGMENT_TIMEOUT;
+
+bool track_ip_fragment(const ip_fragment& frag, const rtps_frame& frame, ip_fragment_tracker& ift) {
+  ip_fragment_key key{0, 0, frag.id, frag.protocol};
+  if (!parse_ipv4(frag.src_ip, key.src) || !parse_ipv4(frag.dst_ip, key.dst)) {
+    return false;
+  }
+  double now = frame.frame_reference_time;
+  expire(now, ift);
+
+  auto it = ift.pending.find(key);
+  if (it == ift.pending.end()) {
+    ip_datagram& dg = ift.pending[key];
+    dg.src_ip = frag.src_ip;
+    dg.dst_ip = frag.dst_ip;
+    dg.id = frag.id;
+    dg.protocol = frag.protocol;
+    dg.first_frame = frame.frame_no;
+    dg.first_time = now;
+    ift.expiry.emplace_back(key, now);
+    it = ift.pending.find(key);
+  }
+
+  ip_datagram& dg = it->second;
+  dg.last_frame = frame.frame_no;
+  dg.last_time = now;
+  ++dg.fragment_count;
+  if (std::find(dg.offsets.begin(), dg.offsets.end(), frag.offset) != dg.offsets.end()) {
+    ++dg.duplicate_count;
+  } else {
+    dg.offsets.push_back(frag.offset);
+    dg.received_bytes += frag.length;
+  }
+  if (!frag.more_fragments) {
+    dg.total_bytes = frag.offset + frag.length;
+  }
+
+  if (dg.total_bytes != 0 && dg.received_bytes >= dg.total_bytes) {
+    dg.complete = true;
+    ift.finished.push_back(std::move(dg));
+    ift.pending.erase(it);
+    return true;
+  }
+  return false;
+}
+
+void finish_ip_fragments(ip_fragment_tracker& ift) {
+  for (auto & it : ift.pending) {
+    ift.finished.push_back(std::move(it.second));
+  }
+  ift.pending.clear();
+  ift.expiry.clear();
+  std::sort(ift.finished.begin(), ift.finished.end(), [](const ip_datagram& a, const ip_datagram& b) { return a.first_frame < b.first_frame; });
+}
+
+void gather_ip_fragment_stats(const ip_fragment_tracker& ift, const rtps_frame_map& frames, ip_fragment_stats& stats) {
+  for (const auto & dg : ift.finished) {
+    ++stats.datagram_count;
+    stats.fragment_count += dg.fragment_count;
+    stats.duplicate_count += dg.duplicate_count;
+    ip_fragment_group_stats& host = stats.by_dst_host[dg.dst_ip];
+    ++host.datagram_count;
+    if (!dg.complete) {
+      ++stats.incomplete_count;
+      ++host.incomplete_count;
+      if (dg.timed_out) {
+        ++stats.timed_out_count;
+      }
+      continue;
+    }
+    ++stats.complete_count;
+    double reconstruction_time = dg.last_time - dg.first_time;
+    if (stats.reconstruction_times.count() == 0 || reconstruction_time > stats.reconstruction_times.max()) {
+      stats.max_frame = dg.last_frame;
+    }
+    stats.reconstruction_times.record(reconstruction_time);
+    host.reconstruction_times.record(reconstruction_time);
+
+    // Only the frame completing the datagram is dissected as RTPS, so that's where the sending participant shows up
+    auto fit = frames.find(dg.last_frame);
+    if (fit != frames.end()) {
+      ip_fragment_group_stats& participant = stats.by_src_participant[fit->second.guid_prefix];
+      ++participant.datagram_count;
+      participant.reconstruction_times.record(reconstruction_time);
+    }
+  }
+}
+
+void print_ip_fragment_stats(std::ostream& os, const ip_fragment_stats& stats, size_t worst_count, bool show_histograms) {
+  os << "IP Fragmentation Stats (all domains):" << std::endl;
+  os << " - Fragmented datagrams: " << stats.datagram_count << " (reassembled: " << stats.complete_count << ", incomplete: " << stats.incomplete_count
+     << ", timed out after " << std::fixed << std::setprecision(0) << ip_fragment_tracker::IP_FRAGMENT_TIMEOUT << "s: " << stats.timed_out_count << ")" << std::endl;
+  os << " - Fragments: " << stats.fragment_count << " (repeated: " << stats.duplicate_count << ")" << std::endl;
+  os << " - Individual Reconstruction Times:" << std::endl;
+  stats.reconstruction_times.print_summary(os, "   ", stats.max_frame != 0 ? " (recovered frame " + std::to_string(stats.max_frame) + ")" : std::string());
+  if (show_histograms) {
+    stats.reconstruction_times.print_histogram(os, "     ");
+  }
+  print_group_stats(os, "Reconstruction Times by Destination Host", stats.by_dst_host, worst_count);
+  print_group_stats(os, "Reconstruction Times by Source Participant", stats.by_src_participant, worst_count);
+  os << std::flush;
+}
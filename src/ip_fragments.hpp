@@ -0,0 +1,91 @@
+#pragma once
+
+#include "frames.hpp"
+#include "hdr_histogram.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ip_fragment {
+  std::string src_ip;
+  std::string dst_ip;
+  uint16_t id;
+  uint8_t protocol;
+  size_t offset;
+  size_t length;
+  bool more_fragments;
+};
+
+struct ip_datagram {
+  std::string src_ip;
+  std::string dst_ip;
+  uint16_t id{0};
+  uint8_t protocol{0};
+  size_t first_frame{0};
+  double first_time{0.0};
+  size_t last_frame{0}; // the frame holding the final missing fragment once complete
+  double last_time{0.0};
+  size_t fragment_count{0};
+  size_t duplicate_count{0};
+  size_t received_bytes{0};
+  size_t total_bytes{0}; // unknown (0) until the fragment without "more fragments" arrives
+  std::vector<size_t> offsets;
+  bool complete{false};
+  bool timed_out{false};
+};
+
+struct ip_fragment_key {
+  uint32_t src;
+  uint32_t dst;
+  uint16_t id;
+  uint8_t protocol;
+};
+
+bool operator==(const ip_fragment_key& a, const ip_fragment_key& b);
+
+struct ip_fragment_key_hash {
+  size_t operator()(const ip_fragment_key& key) const noexcept;
+};
+
+// Reassembly state for IPv4 fragments keyed by (id, src, dst, protocol) as in RFC 791. Datagrams that are still
+// incomplete IP_FRAGMENT_TIMEOUT seconds after their first fragment are evicted, mirroring the Linux ipfrag_time default.
+struct ip_fragment_tracker {
+  static constexpr double IP_FRAGMENT_TIMEOUT = 30.0;
+
+  std::unordered_map<ip_fragment_key, ip_datagram, ip_fragment_key_hash> pending;
+  std::deque<std::pair<ip_fragment_key, double>> expiry;
+  std::vector<ip_datagram> finished; // complete, timed out, or (after finish_ip_fragments) left incomplete
+};
+
+// Records one fragment seen in frame; returns true when it completes its datagram
+bool track_ip_fragment(const ip_fragment& frag, const rtps_frame& frame, ip_fragment_tracker& ift);
+
+// Moves every datagram still waiting for fragments into the finished list as incomplete
+void finish_ip_fragments(ip_fragment_tracker& ift);
+
+struct ip_fragment_group_stats {
+  size_t datagram_count{0};
+  size_t incomplete_count{0};
+  hdr_histogram reconstruction_times;
+};
+
+struct ip_fragment_stats {
+  size_t datagram_count{0};
+  size_t complete_count{0};
+  size_t incomplete_count{0};
+  size_t timed_out_count{0};
+  size_t fragment_count{0};
+  size_t duplicate_count{0};
+  hdr_histogram reconstruction_times;
+  size_t max_frame{0};
+  std::map<std::string, ip_fragment_group_stats> by_dst_host;
+  std::map<std::string, ip_fragment_group_stats> by_src_participant;
+};
+
+void gather_ip_fragment_stats(const ip_fragment_tracker& ift, const rtps_frame_map& frames, ip_fragment_stats& stats);
+void print_ip_fragment_stats(std::ostream& os, const ip_fragment_stats& stats, size_t worst_count, bool show_histograms);
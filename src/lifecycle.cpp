@@ -0,0 +1,111 @@
+#include "lifecycle.hpp"
+
+#include "utils.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+
+void print_latency(std::ostream& os, const std::string& title, const hdr_histogram& h, bool show_histograms) {
+  os << " - " << title << ":" << std::endl;
+  h.print_summary(os, "   ");
+  if (show_histograms) {
+    h.print_histogram(os, "     ");
+  }
+}
+
+}
+
+void gather_lifecycle_info(const endpoint_map& em, const conversation_map& cm, uint16_t domain, lifecycle_info& li) {
+  for (const auto & it : em) {
+    const endpoint_info& info = it.second;
+    if ((domain != 0xFF && domain != info.domain_id) || is_guid_builtin(info.guid)) {
+      continue;
+    }
+    ++li.endpoint_count;
+    if (info.end_reason != EER_NONE) {
+      ++li.ended_endpoint_count;
+      ++li.end_reason_counts[info.end_reason];
+    }
+  }
+
+  // Sweep over +1 / -1 events sorted by time; at equal times ends go first so back-to-back churn doesn't inflate the peak
+  std::vector<std::pair<double, int>> events;
+  for (const auto & it : cm) {
+    for (const auto & it2 : it.second) {
+      const conversation_info& conv = it2.second;
+      if ((domain != 0xFF && domain != conv.domain_id) || is_guid_builtin(conv.writer_guid)) {
+        continue;
+      }
+      ++li.conversation_count;
+      events.emplace_back(conv.first_evidence_time, 1);
+      if (conv.end_reason != EER_NONE) {
+        ++li.ended_conversation_count;
+        events.emplace_back(std::max(conv.end_evidence_time, conv.first_evidence_time), -1);
+      }
+
+      auto wit = em.find(conv.writer_guid);
+      auto rit = em.find(conv.reader_guid);
+      if (wit == em.end() || rit == em.end()) {
+        continue;
+      }
+      const endpoint_info& writer = wit->second;
+      const endpoint_info& reader = rit->second;
+      double known_time = std::max(writer.first_evidence_time, reader.first_evidence_time);
+      auto writer_span = conversation_traffic_span(conv, true);
+      auto reader_span = conversation_traffic_span(conv, false);
+      if (writer_span.first != nullptr) {
+        li.writer_match_latency.record(writer_span.first->frame_reference_time - known_time);
+        if (reader.end_reason != EER_NONE) {
+          li.writer_unmatch_latency.record(std::max(writer_span.second->frame_reference_time - reader.end_evidence_time, 0.0));
+        }
+      }
+      if (reader_span.first != nullptr) {
+        li.reader_match_latency.record(reader_span.first->frame_reference_time - known_time);
+        if (writer.end_reason != EER_NONE) {
+          li.reader_unmatch_latency.record(std::max(reader_span.second->frame_reference_time - writer.end_evidence_time, 0.0));
+        }
+      }
+    }
+  }
+
+  std::sort(events.begin(), events.end());
+  size_t active = 0;
+  for (size_t i = 0; i < events.size(); ++i) {
+    active = static_cast<size_t>(static_cast<long long>(active) + events[i].second);
+    if (i + 1 < events.size() && events[i + 1].first == events[i].first) {
+      continue;
+    }
+    li.active_conversations.emplace_back(events[i].first, active);
+    if (active > li.peak_active) {
+      li.peak_active = active;
+      li.peak_time = events[i].first;
+    }
+  }
+}
+
+void print_lifecycle_stats(std::ostream& os, const lifecycle_info& li, bool show_histograms) {
+  os << "Lifecycle Stats:" << std::endl;
+  os << " - User endpoints: " << li.endpoint_count << " (ended: " << li.ended_endpoint_count;
+  for (size_t r = EER_DISPOSE; r <= EER_LEASE_EXPIRY; ++r) {
+    os << ", " << endpoint_end_reason_name(static_cast<endpoint_end_reason>(r)) << ": " << li.end_reason_counts[r];
+  }
+  os << ")" << std::endl;
+  os << " - User conversations: " << li.conversation_count << " (ended: " << li.ended_conversation_count
+     << ", active at end of capture: " << (li.active_conversations.empty() ? 0 : li.active_conversations.back().second) << ")" << std::endl;
+  os << " - Peak active conversations: " << li.peak_active << " at time " << std::fixed << std::setprecision(3) << li.peak_time << std::endl;
+  print_latency(os, "Writer Match Latency (both endpoints known to writer's first traffic to reader)", li.writer_match_latency, show_histograms);
+  print_latency(os, "Reader Match Latency (both endpoints known to reader's first acknack to writer)", li.reader_match_latency, show_histograms);
+  print_latency(os, "Writer Unmatch Latency (reader's end to writer's last traffic to reader)", li.writer_unmatch_latency, show_histograms);
+  print_latency(os, "Reader Unmatch Latency (writer's end to reader's last acknack to writer)", li.reader_unmatch_latency, show_histograms);
+}
+
+void write_active_conversations_csv(std::ostream& os, const lifecycle_info& li) {
+  os << "time,active_conversations\n";
+  os << std::fixed << std::setprecision(6);
+  for (const auto & it : li.active_conversations) {
+    os << it.first << ',' << it.second << '\n';
+  }
+  os << std::flush;
+}
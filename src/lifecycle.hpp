@@ -0,0 +1,30 @@
+#pragma once
+
+#include "conversation_info.hpp"
+#include "endpoint_info.hpp"
+#include "hdr_histogram.hpp"
+
+#include <ostream>
+#include <utility>
+#include <vector>
+
+struct lifecycle_info {
+  size_t endpoint_count{0};
+  size_t ended_endpoint_count{0};
+  size_t end_reason_counts[EER_LEASE_EXPIRY + 1]{};
+  size_t conversation_count{0};
+  size_t ended_conversation_count{0};
+  std::vector<std::pair<double, size_t>> active_conversations; // (time, active user conversations from then on), one entry per change
+  size_t peak_active{0};
+  double peak_time{0.0};
+  hdr_histogram writer_match_latency;
+  hdr_histogram reader_match_latency;
+  hdr_histogram writer_unmatch_latency;
+  hdr_histogram reader_unmatch_latency;
+};
+
+// Covers user (non-builtin) endpoints and conversations. Match latency runs from the moment both endpoints are known
+// to each side's first traffic towards the other; unmatch latency runs from one side's end to the other side's last traffic.
+void gather_lifecycle_info(const endpoint_map& em, const conversation_map& cm, uint16_t domain, lifecycle_info& li);
+void print_lifecycle_stats(std::ostream& os, const lifecycle_info& li, bool show_histograms);
+void write_active_conversations_csv(std::ostream& os, const lifecycle_info& li);
@@ -0,0 +1,106 @@
+#include "line_scanner.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define RTPARSE_X86 1
+#include <immintrin.h>
+#else
+#define RTPARSE_X86 0
+#endif
+
+namespace {
+
+void add_line(const char* text, size_t begin, size_t end, line_table& lines) {
+  line_entry entry{begin, static_cast<uint32_t>(end - begin), 0, LK_NESTED};
+  const char* line = text + begin;
+  while (entry.indent < entry.length && line[entry.indent] == ' ') {
+    ++entry.indent;
+  }
+  if (entry.length == 0) {
+    entry.kind = LK_BLANK;
+  } else if (entry.indent == 0) {
+    entry.kind = (entry.length >= 6 && std::memcmp(line, "Frame ", 6) == 0) ? LK_FRAME_HEADER : LK_SECTION;
+  }
+  lines.push_back(entry);
+}
+
+// Hands each set bit of a block's newline mask to add_line, returning the start of the next line
+size_t add_block_lines(const char* text, size_t block, uint64_t mask, size_t begin, line_table& lines) {
+  while (mask != 0u) {
+    size_t end = block + static_cast<size_t>(__builtin_ctzll(mask));
+    add_line(text, begin, end, lines);
+    begin = end + 1;
+    mask &= mask - 1;
+  }
+  return begin;
+}
+
+size_t scan_scalar(const char* text, size_t size, size_t pos, size_t begin, line_table& lines) {
+  const char* nl;
+  while (pos < size && (nl = static_cast<const char*>(std::memchr(text + pos, '\n', size - pos))) != nullptr) {
+    size_t end = static_cast<size_t>(nl - text);
+    add_line(text, begin, end, lines);
+    begin = pos = end + 1;
+  }
+  return begin;
+}
+
+#if RTPARSE_X86
+
+// Both vector scanners work on 64 byte blocks and leave the tail to the scalar scanner
+size_t scan_sse2(const char* text, size_t size, size_t& pos, line_table& lines) {
+  const __m128i newline = _mm_set1_epi8('\n');
+  size_t begin = 0;
+  for (; pos + 64 <= size; pos += 64) {
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; ++i) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + pos + 16 * static_cast<size_t>(i)));
+      uint64_t bits = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, newline)));
+      mask |= bits << (16 * i);
+    }
+    begin = add_block_lines(text, pos, mask, begin, lines);
+  }
+  return begin;
+}
+
+__attribute__((target("avx2")))
+size_t scan_avx2(const char* text, size_t size, size_t& pos, line_table& lines) {
+  const __m256i newline = _mm256_set1_epi8('\n');
+  size_t begin = 0;
+  for (; pos + 64 <= size; pos += 64) {
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + pos + 32));
+    uint64_t lo_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, newline)));
+    uint64_t hi_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, newline)));
+    begin = add_block_lines(text, pos, lo_bits | (hi_bits << 32), begin, lines);
+  }
+  return begin;
+}
+
+bool have_avx2() {
+#if defined(__AVX2__)
+  return true;
+#else
+  static const bool result = __builtin_cpu_supports("avx2") != 0;
+  return result;
+#endif
+}
+
+#endif
+
+}
+
+void scan_lines(const char* text, size_t size, line_table& lines) {
+  // tshark fields average a little over 40 characters per line
+  lines.reserve(lines.size() + size / 40);
+  size_t pos = 0;
+  size_t begin = 0;
+#if RTPARSE_X86
+  begin = have_avx2() ? scan_avx2(text, size, pos, lines) : scan_sse2(text, size, pos, lines);
+#endif
+  begin = scan_scalar(text, size, pos, begin, lines);
+  if (begin < size) {
+    add_line(text, begin, size, lines);
+  }
+}
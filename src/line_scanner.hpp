@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum line_kind : uint8_t {
+  LK_NESTED, // indented field line
+  LK_BLANK,
+  LK_FRAME_HEADER, // "Frame N: ..."
+  LK_SECTION // any other unindented line, i.e. a protocol section header
+};
+
+// One line of a tshark verbose dump, as an offset into the text it was scanned from (newline excluded)
+struct line_entry {
+  size_t offset;
+  uint32_t length;
+  uint16_t indent; // leading spaces
+  line_kind kind;
+};
+
+using line_table = std::vector<line_entry>;
+
+// Finds every newline in one pass (AVX2 or SSE2 when the CPU has them, scalar otherwise) and classifies each
+// line as it's found; a final line without a trailing newline is included
+void scan_lines(const char* text, size_t size, line_table& lines);
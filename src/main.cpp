@@ -1,22 +1,49 @@
 #include "boost/program_options/parsers.hpp"
 #include "boost/program_options/variables_map.hpp"
 
+#include "batch.hpp"
+#include "capture.hpp"
+#include "comparison.hpp"
 #include "conversation_info.hpp"
+#include "correlation.hpp"
+#include "discovery_phases.hpp"
+#include "discovery_timeline.hpp"
 #include "endpoint_info.hpp"
+#include "exporter.hpp"
+#include "expected_matches.hpp"
 #include "frames.hpp"
+#include "hdr_histogram.hpp"
+#include "heartbeat_response.hpp"
 #include "info_pairs.hpp"
+#include "ip_fragments.hpp"
+#include "lifecycle.hpp"
 #include "net_info.hpp"
+#include "participant_matrix.hpp"
+#include "pcap_export.hpp"
+#include "repair_analysis.hpp"
+#include "rtps_fragments.hpp"
+#include "throughput.hpp"
+#include "topics.hpp"
 #include "tshark_parsing.hpp"
+#include "undiscovered.hpp"
 #include "utils.hpp"
 
+#include <algorithm>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <thread>
 
 namespace po = boost::program_options;
 
 int run(const po::variables_map& vm);
+int run_correlate(const po::variables_map& vm);
+int run_compare(const po::variables_map& vm);
+int run_batch_mode(const po::variables_map& vm);
+
+// Looks up the conversation named by '<guid1>,<guid2>' (one writer, one reader, in either order), reporting why it can't be found
+bool find_conversation(const std::string& spec, const endpoint_map& em, const conversation_map& cm, const endpoint_info*& writer, const endpoint_info*& reader, const conversation_info*& conv);
 
 int main(int argc, char** argv)
 {
@@ -25,15 +52,48 @@ int main(int argc, char** argv)
   po::options_description desc("Allowed options");
   desc.add_options()
     ("help", "produce help message")
-    ("file", po::value<std::string>(), "input filename")
+    ("file", po::value<string_vec>()->multitoken(), "input filename(s) or wildcard patterns; multiple files are merged by epoch time")
+    ("correlate", po::value<string_vec>()->multitoken(), "correlate simultaneous captures from different hosts (as: '<file1> <file2> ...')")
+    ("compare", po::value<string_vec>()->multitoken(), "compare two runs of the same test, aligning participants by host / port and endpoints by topic (as: '<file1> <file2>')")
+    ("batch", po::value<std::string>(), "analyze every capture in a directory and write per-capture and fleet-level summaries as json")
+    ("batch-output", po::value<std::string>()->default_value("rtparse_batch.json"), "json file written by --batch")
+    ("jobs", po::value<size_t>()->default_value(std::max(1u, std::thread::hardware_concurrency())), "number of captures loaded (or, with --batch, analyzed) at once")
+    ("memory-budget", po::value<size_t>()->default_value(0), "estimated memory (MB) --batch may use across concurrent captures, 0 for unlimited")
     ("show-participants", "show participant information")
     ("show-endpoints", "show endpoint information")
     ("show-conversations", "show conversation information")
     ("show-undiscovered", "show potentially 'undiscovered' endpoint information")
     ("show-discovery-times", "show discovery times for conversations")
-    ("domain", po::value<uint16_t>(), "domain to examine")
+    ("show-histograms", "show log-bucketed histograms alongside latency stats")
+    ("show-heartbeat-response", "show heartbeat to acknack response times and heartbeat periods")
+    ("show-repair-stats", "show nack repair times and retransmission volume")
+    ("show-discovery-timeline", "show cumulative discovery progress and per-participant time to full discovery")
+    ("discovery-timeline-csv", po::value<std::string>(), "write cumulative participant / endpoint / conversation counts over time to a csv file")
+    ("show-discovery-phases", "break user conversation discovery into SPDP / SEDP / first traffic phases and show which dominates the slow tail")
+    ("show-lifecycle", "show endpoint / conversation end-of-life evidence, active conversations and match / unmatch latency")
+    ("lifecycle-csv", po::value<std::string>(), "write the active user conversation count over time to a csv file")
+    ("show-expected-matches", "compare the writer / reader pairs expected from SEDP topic and QoS with the conversations observed")
+    ("show-participant-matrix", "summarize which participant pairs discovered each other (via SEDP) and how long it took")
+    ("participant-matrix", po::value<string_vec>()->multitoken(), "show the participant matrix row and column of these participants (guids or guid prefixes)")
+    ("participant-matrix-csv", po::value<std::string>(), "write the participant x participant discovery state and latency to a csv file")
+    ("show-topics", "group endpoint counts, conversations, discovery times and throughput by SEDP topic name")
+    ("throughput", "show per-writer throughput (samples/s, bytes/s, peaks and burstiness)")
+    ("throughput-bin", po::value<double>()->default_value(1.0), "throughput time bin width in seconds")
+    ("throughput-csv", po::value<std::string>(), "write the per-writer throughput time series to a csv file")
+    ("export-format", po::value<std::string>()->default_value("jsonl"), "format of exported files: jsonl (JSON Lines) or csv")
+    ("export-endpoints", po::value<std::string>(), "export one row per endpoint to a file")
+    ("export-conversations", po::value<std::string>(), "export one row per conversation to a file")
+    ("export-events", po::value<std::string>(), "export one row per submessage of each conversation to a file")
+    ("export-stats", po::value<std::string>(), "export discovery and fragment latency distributions to a file")
+    ("frag-table-size", po::value<size_t>()->default_value(65536), "maximum number of fragmented samples tracked at once for RTPS fragment reassembly")
+    ("worst", po::value<size_t>()->default_value(10), "number of worst entries to list in per-conversation reports")
+    ("domain", po::value<uint16_t>(), "domain to examine, by the domain SPDP announces for each participant; applied after parsing, so only multicast to another domain's well-known ports is skipped early")
+    ("guid", po::value<string_vec>()->multitoken(), "only parse frames sent by or addressed to these participants (full guids or guid prefixes)")
+    ("start-time", po::value<double>(), "only parse frames at or after this many seconds from the start of the capture (of the merged capture, when several files are given)")
+    ("end-time", po::value<double>(), "only parse frames at or before this many seconds from the start of the capture (of the merged capture, when several files are given)")
     ("show-conversation-frames", po::value<string_vec>(), "show frames relevant to conversation between two guids (as: '<guid1>,<guid2>')")
-    //("guid", po::value<string_vec>(), "guid to examine") // TODO Add support for filtering by guid eventually?
+    ("pcap", po::value<string_vec>()->multitoken(), "original (classic pcap) capture(s) the tshark text was produced from, in the same order as --file")
+    ("export-conversation-pcap", po::value<string_vec>()->multitoken(), "copy the frames shown by --show-conversation-frames from --pcap into a new pcap file (as: '<guid1>,<guid2> <out.pcap>')")
   ;
 
   po::variables_map vm;
@@ -46,7 +106,15 @@ int main(int argc, char** argv)
   }
 
   try {
-    result = run(vm);
+    if (vm.count("correlate") != 0u) {
+      result = run_correlate(vm);
+    } else if (vm.count("compare") != 0u) {
+      result = run_compare(vm);
+    } else if (vm.count("batch") != 0u) {
+      result = run_batch_mode(vm);
+    } else {
+      result = run(vm);
+    }
   } catch (...) {
     result = 1;
   }
@@ -54,69 +122,240 @@ int main(int argc, char** argv)
   return result;
 }
 
-int run(const po::variables_map& vm) { 
+int run_correlate(const po::variables_map& vm) {
+  string_vec filenames = vm["correlate"].as<string_vec>();
+  if (filenames.size() < 2) {
+    std::cout << "At least two files are needed for correlation.\n";
+    return 1;
+  }
+  for (const auto & filename : filenames) {
+    std::cout << "Using file: " << filename << std::endl;
+  }
 
-  std::string filename;
-  if (vm.count("file") != 0u) {
-    filename = vm["file"].as<std::string>();
-    std::cout << "Using file: " << vm["file"].as<std::string>() << std::endl;
-  } else {
-    std::cout << "Input file was not set.\n";
+  std::vector<capture> caps;
+  if (!load_captures(filenames, caps, false, frame_filter(), vm["jobs"].as<size_t>())) {
     return 1;
   }
 
-  std::ifstream ifs(filename.c_str());
+  capture_correlation cc;
+  correlate_captures(caps, cc);
+  std::cout << std::endl;
+  print_correlation_stats(std::cout, caps, cc, vm.count("show-histograms") != 0u);
+  return 0;
+}
 
-  if (!ifs.good()) {
-    std::cout << "Unable to open input file " << filename << std::endl;
+int run_compare(const po::variables_map& vm) {
+  string_vec filenames = vm["compare"].as<string_vec>();
+  if (filenames.size() != 2) {
+    std::cout << "Exactly two files are needed for comparison.\n";
     return 1;
   }
+  for (const auto & filename : filenames) {
+    std::cout << "Using file: " << filename << std::endl;
+  }
 
   uint16_t domain = 0xFF;
   if (vm.count("domain") != 0u) {
     domain = vm["domain"].as<uint16_t>();
   }
+  frame_filter filter;
+  filter.domain = domain;
 
-  /*
-  // TODO Add support for filtering by guid eventually?
-  string_vec guids;
-  if (vm.count("guid") != 0u) {
-    guids = vm["guid"].as<string_vec>();
-    for (auto it = guids.begin(); it != guids.end(); ++it) {
-      std::cout << "tracking guid: " << *it << std::endl;
+  std::vector<capture> caps;
+  if (!load_captures(filenames, caps, false, filter, vm["jobs"].as<size_t>())) {
+    return 1;
+  }
+  for (auto & cap : caps) {
+    filter_capture_domain(cap, filter);
+  }
+
+  std::vector<run_summary> summaries(caps.size());
+  std::vector<char> failed(caps.size(), 0);
+  size_t frag_table_size = vm["frag-table-size"].as<size_t>();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < caps.size(); ++i) {
+    // An exception escaping a thread would terminate the process, so it's recorded and reported after the join
+    threads.emplace_back([&, i]() {
+      try {
+        gather_run_summary(caps[i], domain, frag_table_size, summaries[i]);
+      } catch (...) {
+        failed[i] = 1;
+      }
+    });
+  }
+  for (auto & thread : threads) {
+    thread.join();
+  }
+  for (size_t i = 0; i < caps.size(); ++i) {
+    if (failed[i] != 0) {
+      std::cout << "Failed to analyze " << filenames[i] << std::endl;
+      return 1;
+    }
+  }
+
+  std::cout << std::endl;
+  print_run_comparison(std::cout, summaries[0], summaries[1], vm["worst"].as<size_t>());
+  return 0;
+}
+
+int run_batch_mode(const po::variables_map& vm) {
+  string_vec filenames = list_batch_captures(vm["batch"].as<std::string>());
+  if (filenames.empty()) {
+    std::cout << "No captures found in " << vm["batch"].as<std::string>() << std::endl;
+    return 1;
+  }
+
+  batch_options opts;
+  opts.jobs = vm["jobs"].as<size_t>();
+  opts.memory_budget = vm["memory-budget"].as<size_t>() << 20;
+  if (vm.count("domain") != 0u) {
+    opts.domain = vm["domain"].as<uint16_t>();
+  }
+  opts.frag_table_size = vm["frag-table-size"].as<size_t>();
+  opts.worst_count = vm["worst"].as<size_t>();
+
+  std::cout << "Analyzing " << filenames.size() << " captures with " << opts.jobs << " jobs" << std::endl;
+  std::vector<batch_result> results;
+  run_batch(filenames, opts, results);
+
+  size_t failed = 0;
+  for (const auto & r : results) {
+    if (!r.ok) {
+      ++failed;
+      std::cout << "Failed to analyze " << r.filename << ": " << r.error << std::endl;
+    }
+  }
+
+  std::ofstream ofs(vm["batch-output"].as<std::string>().c_str());
+  if (!ofs.good()) {
+    std::cout << "Unable to open batch output file " << vm["batch-output"].as<std::string>() << std::endl;
+    return 1;
+  }
+  write_batch_json(ofs, results, opts.worst_count);
+  std::cout << "Wrote " << results.size() << " capture summaries (" << failed << " failed) to " << vm["batch-output"].as<std::string>() << std::endl;
+  return 0;
+}
+
+bool find_conversation(const std::string& spec, const endpoint_map& em, const conversation_map& cm, const endpoint_info*& writer, const endpoint_info*& reader, const conversation_info*& conv) {
+  size_t cpos = 0;
+  if (spec.length() != 65 || ((cpos = spec.find(',')) != 32)) {
+    std::cout << "error parsing conversation! cpos = " << cpos << std::endl;
+    return false;
+  }
+  std::string guid1 = spec.substr(0, 32);
+  std::string guid2 = spec.substr(33, 32);
+  std::string writer_guid;
+  std::string reader_guid;
+  if (guid1[guid1.length() - 1] == '2' && guid2[guid2.length() - 1] == '7') {
+    writer_guid = guid1;
+    reader_guid = guid2;
+  } else if (guid1[guid1.length() - 1] == '7' && guid2[guid2.length() - 1] == '2') {
+    writer_guid = guid2;
+    reader_guid = guid1;
+  } else {
+    std::cout << "not a conversation! needs one writer and one reader" << std::endl;
+    return false;
+  }
+  auto wit = em.find(writer_guid);
+  if (wit == em.end()) {
+    std::cout << "unable to find writer in endpoint map!" << std::endl;
+    return false;
+  }
+  auto rit = em.find(reader_guid);
+  if (rit == em.end()) {
+    std::cout << "unable to find reader in endpoint map!" << std::endl;
+    return false;
+  }
+  auto cit1 = cm.find(writer_guid);
+  if (cit1 == cm.end()) {
+    std::cout << "unable to find writer in conversation map!" << std::endl;
+    return false;
+  }
+  auto cit2 = cit1->second.find(reader_guid);
+  if (cit2 == cit1->second.end()) {
+    std::cout << "unable to find reader in conversation map!" << std::endl;
+    return false;
+  }
+  writer = &wit->second;
+  reader = &rit->second;
+  conv = &cit2->second;
+  return true;
+}
+
+int run(const po::variables_map& vm) { 
+
+  string_vec filenames;
+  if (vm.count("file") != 0u) {
+    filenames = expand_capture_patterns(vm["file"].as<string_vec>());
+    for (const auto & filename : filenames) {
+      std::cout << "Using file: " << filename << std::endl;
     }
+  } else {
+    std::cout << "Input file was not set.\n";
+    return 1;
   }
-  */
 
-  tshark_frame_map tfm;
+  bool show_discovery_times = vm.count("show-discovery-times") != 0u;
+  bool show_histograms = vm.count("show-histograms") != 0u;
+  bool show_topics = vm.count("show-topics") != 0u;
+  size_t worst_count = vm["worst"].as<size_t>();
+
+  uint16_t domain = 0xFF;
+  if (vm.count("domain") != 0u) {
+    domain = vm["domain"].as<uint16_t>();
+  }
 
-  std::string line;
-  std::getline(ifs, line);
-  size_t frame_no = 0;
-  while (ifs.good()) {
-    if (line.substr(0, 6) == "Frame ") {
-      std::stringstream ss(line.substr(6, line.find(':')));
-      ss >> frame_no;
-      //std::cout << "Found header for frame " << frame << std::endl;
+  frame_filter filter;
+  filter.domain = domain;
+  if (vm.count("guid") != 0u) {
+    set_filter_guids(filter, vm["guid"].as<string_vec>());
+    for (const auto & prefix : filter.guid_prefixes) {
+      std::cout << "Tracking participant: " << prefix << std::endl;
     }
-    tfm[frame_no].push_back(line);
-    std::getline(ifs, line);
+  }
+  if (vm.count("start-time") != 0u) {
+    filter.start_time = vm["start-time"].as<double>();
+  }
+  if (vm.count("end-time") != 0u) {
+    filter.end_time = vm["end-time"].as<double>();
   }
 
-  rtps_frame_map frames;
-  ip_frag_map ifm;
-  process_frame_data(tfm, frames, ifm);
+  capture cap;
+  if (filenames.size() == 1) {
+    if (!load_capture(filenames.front(), cap, true, filter)) {
+      return 1;
+    }
+  } else {
+    // Each file's times are relative to its own first frame until the merge rebases them, so the window waits for that
+    frame_filter load_filter = filter;
+    load_filter.start_time = frame_filter().start_time;
+    load_filter.end_time = frame_filter().end_time;
+    std::vector<capture> caps;
+    if (!load_captures(filenames, caps, true, load_filter, vm["jobs"].as<size_t>())) {
+      return 1;
+    }
+    merge_captures(caps, cap);
+    filter_capture_times(cap, filter);
+  }
+  filter_capture_domain(cap, filter);
+  std::cout << "Frames read: " << cap.frame_count << " (non-RTPS skipped: " << cap.non_rtps_frame_count
+            << ", dropped by filters: " << cap.filtered_frame_count << ", RTPS parsed: " << cap.frames.size() << ")" << std::endl;
+  const tshark_frame_map& tfm = cap.tfm;
+  const rtps_frame_map& frames = cap.frames;
 
   endpoint_map em;
   gather_participant_info(frames, em);
   gather_endpoint_info(frames, em);
+  gather_endpoint_lifecycle(frames, em);
+  topic_index topics;
+  gather_topic_index(em, topics);
 
   // Display Endpoint Info
   if (vm.count("show-endpoints") != 0u) {
     std::cout << "Endpoint Info:" << std::endl;
     for (auto & it : em) {
       if (domain == 0xFF || domain == it.second.domain_id) {
-        std::cout << it.second << std::endl;
+        std::cout << it.second << '\n';
       }
     }
   }
@@ -145,12 +384,13 @@ int run(const po::variables_map& vm) {
   if (vm.count("show-participants") != 0u) {
     std::cout << "Participant guids:" << std::endl;
     for (const auto & participant_guid : participant_guids) {
-      std::cout << participant_guid << std::endl;
+      std::cout << participant_guid << '\n';
     }
   }
 
   conversation_map cm;
   gather_conversation_info(frames, em, cm);
+  gather_conversation_lifecycle(em, cm);
 
   std::set<std::string> conversation_guids;
   if (vm.count("show-conversations") != 0u) {
@@ -161,81 +401,112 @@ int run(const po::variables_map& vm) {
       if (domain == 0xFF || domain == it2.second.domain_id) {
         conversation_guids.insert(it2.second.writer_guid);
         conversation_guids.insert(it2.second.reader_guid);
-        if (vm.count("show-conversations") != 0u) {
-          std::cout << "Conversation found: " << it2.second.writer_guid << " >> " << it2.second.reader_guid << " @ " << it2.second.first_evidence_time << std::endl;
+        if (vm.count("show-conversations") != 0u && !show_topics) {
+          std::cout << "Conversation found: " << it2.second.writer_guid << " >> " << it2.second.reader_guid << " @ " << it2.second.first_evidence_time << '\n';
         }
       }
     }
   }
-
-  if (vm.count("show-conversation-frames") != 0u) {
-    string_vec clist = vm["show-conversation-frames"].as<string_vec>();
-    for (auto & it : clist) {
-      size_t cpos = 0;
-      if (it.length() != 65 || ((cpos = it.find(',')) != 32)) {
-        std::cout << "error parsing conversation! cpos = " << cpos << std::endl;
+  if (vm.count("show-conversations") != 0u && show_topics) {
+    std::vector<std::vector<const conversation_info*>> by_topic;
+    gather_topic_conversations(topics, em, cm, domain, by_topic);
+    for (size_t i = 0; i <= topics.topics.size(); ++i) {
+      if (by_topic[i].empty()) {
         continue;
       }
-      std::string guid1 = it.substr(0, 32);
-      std::string guid2 = it.substr(33, 32);
-      std::string writer_guid;
-      std::string reader_guid;
-      if (guid1[guid1.length() - 1] == '2' && guid2[guid2.length() - 1] == '7') {
-        writer_guid = guid1;
-        reader_guid = guid2;
-      } else if (guid1[guid1.length() - 1] == '7' && guid2[guid2.length() - 1] == '2') {
-        writer_guid = guid2;
-        reader_guid = guid1;
+      if (i < topics.topics.size()) {
+        std::cout << " - " << topics.topics[i].name << " (" << topics.topics[i].type_name << "):" << '\n';
       } else {
-        std::cout << "not a conversation! needs one writer and one reader" << std::endl;
-        continue;
+        std::cout << " - No topic (builtin or unannounced):" << '\n';
       }
-      auto wit = em.find(writer_guid);
-      if (wit == em.end()) {
-        std::cout << "unable to find writer in endpoint map!" << std::endl;
-        continue;
-      }
-      auto rit = em.find(reader_guid);
-      if (rit == em.end()) {
-        std::cout << "unable to find reader in endpoint map!" << std::endl;
-        continue;
-      }
-      auto cit1 = cm.find(writer_guid);
-      if (cit1 == cm.end()) {
-        std::cout << "unable to find writer in conversation map!" << std::endl;
-        continue;
+      for (const conversation_info* conv : by_topic[i]) {
+        std::cout << "   Conversation found: " << conv->writer_guid << " >> " << conv->reader_guid << " @ " << conv->first_evidence_time << '\n';
       }
-      auto cit2 = cit1->second.find(reader_guid);
-      if (cit2 == cit1->second.end()) {
-        std::cout << "unable to find reader in conversation map!" << std::endl;
+    }
+  }
+
+  if (vm.count("show-conversation-frames") != 0u) {
+    string_vec clist = vm["show-conversation-frames"].as<string_vec>();
+    for (auto & it : clist) {
+      const endpoint_info* winfo = nullptr;
+      const endpoint_info* rinfo = nullptr;
+      const conversation_info* conv = nullptr;
+      if (!find_conversation(it, em, cm, winfo, rinfo, conv)) {
         continue;
       }
-      const auto& cinfo = cit2->second;
-      std::set<size_t> cframes;
+      const std::string& writer_guid = winfo->guid;
+      const std::string& reader_guid = rinfo->guid;
+      const auto& cinfo = *conv;
+      std::set<size_t> cframes = gather_conversation_frames(*winfo, *rinfo, cinfo);
       std::cout << "Frame summary for conversation " << writer_guid << " >> " << reader_guid << ":" << std::endl;
-      std::cout << " - First evidence of writer at frame " << wit->second.first_evidence_frame << " at time " << std::fixed << std::setprecision(3) << wit->second.first_evidence_time << std::endl;
-      cframes.insert(wit->second.first_evidence_frame);
-      std::cout << " - First evidence of reader at frame " << rit->second.first_evidence_frame << " at time " << std::fixed << std::setprecision(3) << rit->second.first_evidence_time << std::endl;
-      cframes.insert(rit->second.first_evidence_frame);
+      std::cout << " - First evidence of writer at frame " << winfo->first_evidence_frame << " at time " << std::fixed << std::setprecision(3) << winfo->first_evidence_time << std::endl;
+      std::cout << " - First evidence of reader at frame " << rinfo->first_evidence_frame << " at time " << std::fixed << std::setprecision(3) << rinfo->first_evidence_time << std::endl;
       std::cout << " - First evidence of conversation in frame " << cinfo.first_evidence_frame << " at time " << std::fixed << std::setprecision(3) << cinfo.first_evidence_time << std::endl;
-      cframes.insert(cinfo.first_evidence_frame);
       std::map<size_t, std::shared_ptr<info_pair_printer_base>> fmap;
-      std::for_each(cinfo.datas.begin(), cinfo.datas.end(), [&](const auto& v) { cframes.insert(v.first->frame_no); fmap[v.first->frame_no].reset(new data_info_pair_printer(v)); });
-      std::for_each(cinfo.gaps.begin(), cinfo.gaps.end(), [&](const auto& v) { cframes.insert(v.first->frame_no); fmap[v.first->frame_no].reset(new gap_info_pair_printer(v)); });
-      std::for_each(cinfo.heartbeats.begin(), cinfo.heartbeats.end(), [&](const auto& v) { cframes.insert(v.first->frame_no); fmap[v.first->frame_no].reset(new hb_info_pair_printer(v)); });
-      std::for_each(cinfo.acknacks.begin(), cinfo.acknacks.end(), [&](const auto& v) { cframes.insert(v.first->frame_no); fmap[v.first->frame_no].reset(new an_info_pair_printer(v)); });
-      std::for_each(fmap.begin(), fmap.end(), [&](const auto& v) { v.second->print(std::cout) << std::endl; });
+      std::for_each(cinfo.datas.begin(), cinfo.datas.end(), [&](const auto& v) { fmap[v.first->frame_no].reset(new data_info_pair_printer(v)); });
+      std::for_each(cinfo.gaps.begin(), cinfo.gaps.end(), [&](const auto& v) { fmap[v.first->frame_no].reset(new gap_info_pair_printer(v)); });
+      std::for_each(cinfo.heartbeats.begin(), cinfo.heartbeats.end(), [&](const auto& v) { fmap[v.first->frame_no].reset(new hb_info_pair_printer(v)); });
+      std::for_each(cinfo.acknacks.begin(), cinfo.acknacks.end(), [&](const auto& v) { fmap[v.first->frame_no].reset(new an_info_pair_printer(v)); });
+      std::for_each(cinfo.data_frags.begin(), cinfo.data_frags.end(), [&](const auto& v) { fmap[v.first->frame_no].reset(new df_info_pair_printer(v)); });
+      std::for_each(cinfo.heartbeat_frags.begin(), cinfo.heartbeat_frags.end(), [&](const auto& v) { fmap[v.first->frame_no].reset(new hbf_info_pair_printer(v)); });
+      std::for_each(cinfo.nack_frags.begin(), cinfo.nack_frags.end(), [&](const auto& v) { fmap[v.first->frame_no].reset(new nf_info_pair_printer(v)); });
+      std::for_each(fmap.begin(), fmap.end(), [&](const auto& v) { v.second->print(std::cout) << '\n'; });
       for (size_t cframe : cframes) {
         auto fit = tfm.find(cframe);
         if (fit != tfm.end()) {
+          std::string source = describe_frame_source(cap, cframe);
+          if (!source.empty()) {
+            std::cout << "(merged frame " << cframe << " is " << source << ")\n";
+          }
           for (auto & tfmit : fit->second) {
-            std::cout << tfmit << std::endl;
+            std::cout << tfmit << '\n';
           }
         }
       }
     }
   }
 
+  if (vm.count("export-conversation-pcap") != 0u) {
+    string_vec args = vm["export-conversation-pcap"].as<string_vec>();
+    string_vec pcap_filenames;
+    if (vm.count("pcap") != 0u) {
+      pcap_filenames = expand_capture_patterns(vm["pcap"].as<string_vec>());
+    }
+    std::vector<pcap_index> indexes(pcap_filenames.size());
+    bool indexed = true;
+    for (size_t i = 0; i < pcap_filenames.size() && indexed; ++i) {
+      indexed = index_pcap(pcap_filenames[i], indexes[i]);
+    }
+    if (args.size() % 2 != 0) {
+      std::cout << "--export-conversation-pcap needs a conversation and an output file (as: '<guid1>,<guid2> <out.pcap>')" << std::endl;
+    } else if (pcap_filenames.size() != filenames.size()) {
+      std::cout << "--export-conversation-pcap needs one --pcap file per input file (" << filenames.size() << ")" << std::endl;
+    } else if (indexed) {
+      for (size_t i = 0; i < args.size(); i += 2) {
+        const endpoint_info* winfo = nullptr;
+        const endpoint_info* rinfo = nullptr;
+        const conversation_info* conv = nullptr;
+        if (!find_conversation(args[i], em, cm, winfo, rinfo, conv)) {
+          continue;
+        }
+        // Merged captures are renumbered, so frames are mapped back to their file and original frame number
+        std::vector<pcap_frame_ref> refs;
+        for (size_t cframe : gather_conversation_frames(*winfo, *rinfo, *conv)) {
+          auto fit = frames.find(cframe);
+          double epoch_time = fit == frames.end() ? -1.0 : fit->second.frame_epoch_time;
+          if (cap.frame_sources.empty()) {
+            refs.push_back(pcap_frame_ref{0, cframe, epoch_time});
+          } else {
+            refs.push_back(pcap_frame_ref{cap.frame_sources[cframe].file_index, cap.frame_sources[cframe].frame_no, epoch_time});
+          }
+        }
+        if (write_pcap_frames(indexes, refs, args[i + 1])) {
+          std::cout << "Wrote " << refs.size() << " frames of conversation " << winfo->guid << " >> " << rinfo->guid << " to " << args[i + 1] << std::endl;
+        }
+      }
+    }
+  }
+
   std::set<std::string> undiscovered_guids;
   std::set<std::string> total_considered_endpoints;
   for (auto & it : em) {
@@ -256,66 +527,65 @@ int run(const po::variables_map& vm) {
 
   if (vm.count("show-undiscovered") != 0u) {
     std::cout << "Implicit and/or explicit reliable endpoints without evidence of a conversation:" << std::endl;
-    for (const auto & undiscovered_guid : undiscovered_guids) {
-      std::cout << undiscovered_guid << std::endl;
-    }
+    undiscovered_info ui;
+    gather_undiscovered_info(em, cm, undiscovered_guids, ui);
+    print_undiscovered_info(std::cout, ui);
   }
 
   // Calculate IP Fragmentation Reconstruction Times
-  std::multimap<double, const rtps_frame*> ft;
-  size_t ft_dropped_count = 0;
-  for (auto & it : ifm) {
-    auto it2 = frames.find(it.second.second);
-    if (it2 != frames.end()) {
-      //std::cout << "frame " << it->second.second << " at " << it2->second.frame_reference_time << " - frame fragment " << it->second.first.first << " at " << it->second.first.second << std::endl;
-      ft.insert(decltype(ft)::value_type(it2->second.frame_reference_time - it.second.first.second, &(it2->second)));
-    } else {
-      ++ft_dropped_count;
-    }
-  }
+  ip_fragment_stats ifs;
+  gather_ip_fragment_stats(cap.ift, frames, ifs);
+  print_ip_fragment_stats(std::cout, ifs, worst_count, show_histograms);
 
-  double ft_min = ft.empty() ? 0.0 : ft.begin()->first;
-  double ft_max = ft.empty() ? 0.0 : ft.rbegin()->first;
-  double ft_mean = 0.0, ft_median = 0.0;
-  std::vector<double> ft_median_vec;
-  for (auto & it : ft) {
-    //if (domain == 0xFF || domain == it->second->domain_id) // TODO fix domain lookup for individual frames (domain_id here isn't always correct)
-    {
-      ft_mean += it.first;
-      ft_median_vec.push_back(it.first);
-    }
-  }
-  if (!ft_median_vec.empty()) {
-    ft_mean /= ft_median_vec.size();
-    ft_median = ft_median_vec[std::floor((ft_median_vec.size() - 1) / 2)];
-  }
-
-  std::cout << "IP Fragmentation Stats (all domains):" << std::endl;
-  std::cout << " - Unrecovered fragments: " << ft_dropped_count << std::endl;
-  std::cout << " - Individual Reconstruction Times:" << std::endl;
-  std::cout << "   - Min:    " << std::setw(8) << std::fixed << std::setprecision(6) << ft_min << std::endl;
-  std::cout << "   - Median: " << std::setw(8) << std::fixed << std::setprecision(6) << ft_median << std::endl;
-  std::cout << "   - Mean:   " << std::setw(8) << std::fixed << std::setprecision(6) << ft_mean << std::endl;
-  std::cout << "   - Max:    " << std::setw(8) << std::fixed << std::setprecision(6) << ft_max << std::flush;
-  if (!ft.empty()) {
-    std::cout << " (recovered frame " << ft.rbegin()->second->frame_no << ")" << std::flush;
-  }
-  std::cout << std::endl;
+  // Calculate RTPS Fragment Reassembly Times (per-frame domain ids suffer from the same issue as above)
+  rtps_fragment_stats rfs;
+  gather_rtps_fragment_stats(frames, 0xFF, vm["frag-table-size"].as<size_t>(), rfs);
+  print_rtps_fragment_stats(std::cout, rfs, worst_count, show_histograms);
 
   // Calculate Discovery Times
-  std::multimap<double, const conversation_info*> dt;
-  std::multimap<double, const conversation_info*> dt_b;
-  std::multimap<double, const conversation_info*> dt_u;
+  hdr_histogram dt;
+  hdr_histogram dt_b;
+  hdr_histogram dt_u;
+  const conversation_info* dt_max_conv = nullptr;
+  const conversation_info* dt_b_max_conv = nullptr;
+  const conversation_info* dt_u_max_conv = nullptr;
+  std::vector<std::pair<double, const conversation_info*>> dt_list;
+  std::vector<std::pair<double, const conversation_info*>> dt_u_list;
+  std::vector<hdr_histogram> dt_t(show_topics ? topics.topics.size() : 0);
+  std::vector<const conversation_info*> dt_t_max_conv(dt_t.size(), nullptr);
   double last_conversation_time = 0.0;
   for (auto & it : cm) {
     for (auto & it2 : it.second) {
       if (domain == 0xFF || domain == it2.second.domain_id) {
         double second_evidence_time = std::max(em[it2.second.writer_guid].first_evidence_time, em[it2.second.reader_guid].first_evidence_time);
-        dt.insert(decltype(dt)::value_type(it2.second.first_evidence_time - second_evidence_time, &(it2.second)));
+        double discovery_time = it2.second.first_evidence_time - second_evidence_time;
+        if (dt.count() == 0 || discovery_time > dt.max()) {
+          dt_max_conv = &(it2.second);
+        }
+        dt.record(discovery_time);
+        if (show_discovery_times) {
+          dt_list.emplace_back(discovery_time, &(it2.second));
+        }
         if (is_guid_builtin(it2.second.writer_guid)) {
-          dt_b.insert(decltype(dt)::value_type(it2.second.first_evidence_time - second_evidence_time, &(it2.second)));
+          if (dt_b.count() == 0 || discovery_time > dt_b.max()) {
+            dt_b_max_conv = &(it2.second);
+          }
+          dt_b.record(discovery_time);
         } else {
-          dt_u.insert(decltype(dt)::value_type(it2.second.first_evidence_time - second_evidence_time, &(it2.second)));
+          if (dt_u.count() == 0 || discovery_time > dt_u.max()) {
+            dt_u_max_conv = &(it2.second);
+          }
+          dt_u.record(discovery_time);
+          if (show_discovery_times) {
+            dt_u_list.emplace_back(discovery_time, &(it2.second));
+          }
+          uint32_t topic_id = em[it2.second.writer_guid].topic_id;
+          if (topic_id < dt_t.size()) {
+            if (dt_t[topic_id].count() == 0 || discovery_time > dt_t[topic_id].max()) {
+              dt_t_max_conv[topic_id] = &(it2.second);
+            }
+            dt_t[topic_id].record(discovery_time);
+          }
         }
         if (it2.second.first_evidence_time > last_conversation_time) {
           last_conversation_time = it2.second.first_evidence_time;
@@ -324,75 +594,190 @@ int run(const po::variables_map& vm) {
     }
   }
 
-  if (vm.count("show-discovery-times") != 0u) {
+  if (show_discovery_times) {
+    auto by_time = [](const auto& a, const auto& b) { return a.first < b.first; };
+    std::stable_sort(dt_list.begin(), dt_list.end(), by_time);
     std::cout << "discovery times:" << std::endl;
-  }
-  double dt_min = dt.empty() ? 0.0 : dt.begin()->first;
-  double dt_max = dt.empty() ? 0.0 : dt.rbegin()->first;
-  double dt_mean = 0.0, dt_median = 0.0;
-  std::vector<double> dt_median_vec;
-  for (auto & it : dt) {
-    if (domain == 0xFF || domain == it.second->domain_id) {
-      dt_mean += it.first;
-      dt_median_vec.push_back(it.first);
-      if (vm.count("show-discovery-times") != 0u) {
-        std::cout << it.second->writer_guid << " <-> " << it.second->reader_guid << " took " << it.first << " seconds" << std::endl;
-      }
+    for (auto & it : dt_list) {
+      std::cout << it.second->writer_guid << " <-> " << it.second->reader_guid << " took " << it.first << " seconds" << '\n';
     }
   }
-  if (!dt_median_vec.empty()) {
-    dt_mean /= dt_median_vec.size();
-    dt_median = dt_median_vec[std::floor((dt_median_vec.size() - 1) / 2)];
-  }
 
   std::cout << "Discovery Stats:" << std::endl;
   std::cout << " - Total Conversations: " << conversation_guids.size() / 2 << std::endl;
   std::cout << " - Reliable endpoints without evidence of conversation: " << undiscovered_guids.size() << std::endl;
   std::cout << " - Individual Discovery Times:" << std::endl;
-  std::cout << "   - Min:    " << dt_min << std::endl;
-  std::cout << "   - Median: " << dt_median << std::endl;
-  std::cout << "   - Mean:   " << dt_mean << std::endl;
-  std::cout << "   - Max:    " << dt_max << std::flush;
-  if (!dt.empty()) {
-    std::cout << " (" << dt.rbegin()->second->writer_guid << " >> " << dt.rbegin()->second->reader_guid << ")" << std::flush;
+  dt.print_summary(std::cout, "   ", dt_max_conv ? " (" + dt_max_conv->writer_guid + " >> " + dt_max_conv->reader_guid + ")" : std::string());
+  if (show_histograms) {
+    dt.print_histogram(std::cout, "     ");
   }
-  std::cout << std::endl;
 
-  if (vm.count("show-discovery-times") != 0u) {
-    std::cout << "discovery times:" << std::endl;
+  std::cout << " - Individual Discovery Times (Builtin Endpoints):" << std::endl;
+  dt_b.print_summary(std::cout, "   ", dt_b_max_conv ? " (" + dt_b_max_conv->writer_guid + " >> " + dt_b_max_conv->reader_guid + ")" : std::string());
+  if (show_histograms) {
+    dt_b.print_histogram(std::cout, "     ");
   }
-  double dt_u_min = dt_u.empty() ? 0.0 : dt_u.begin()->first;
-  double dt_u_max = dt_u.empty() ? 0.0 : dt_u.rbegin()->first;
-  double dt_u_mean = 0.0, dt_u_median = 0.0;
-  std::vector<double> dt_u_median_vec;
-  for (auto & it : dt_u) {
-    if (domain == 0xFF || domain == it.second->domain_id) {
-      dt_u_mean += it.first;
-      dt_u_median_vec.push_back(it.first);
-      if (vm.count("show-discovery-times") != 0u) {
-        std::cout << it.second->writer_guid << " <-> " << it.second->reader_guid << " took " << it.first << " seconds" << std::endl;
-      }
+
+  if (show_discovery_times) {
+    auto by_time = [](const auto& a, const auto& b) { return a.first < b.first; };
+    std::stable_sort(dt_u_list.begin(), dt_u_list.end(), by_time);
+    std::cout << "discovery times:" << std::endl;
+    for (auto & it : dt_u_list) {
+      std::cout << it.second->writer_guid << " <-> " << it.second->reader_guid << " took " << it.first << " seconds" << '\n';
     }
   }
-  if (!dt_u_median_vec.empty()) {
-    dt_u_mean /= dt_u_median_vec.size();
-    dt_u_median = dt_u_median_vec[std::floor((dt_u_median_vec.size() - 1) / 2)];
-  }
 
   std::cout << " - Individual Discovery Times (User Data Endpoints):" << std::endl;
-  std::cout << "   - Min:    " << dt_u_min << std::endl;
-  std::cout << "   - Median: " << dt_u_median << std::endl;
-  std::cout << "   - Mean:   " << dt_u_mean << std::endl;
-  std::cout << "   - Max:    " << dt_u_max << std::flush;
-  if (!dt_u.empty()) {
-    std::cout << " (" << dt_u.rbegin()->second->writer_guid << " >> " << dt_u.rbegin()->second->reader_guid << ")" << std::flush;
+  dt_u.print_summary(std::cout, "   ", dt_u_max_conv ? " (" + dt_u_max_conv->writer_guid + " >> " + dt_u_max_conv->reader_guid + ")" : std::string());
+  if (show_histograms) {
+    dt_u.print_histogram(std::cout, "     ");
+  }
+
+  if (show_topics) {
+    std::cout << " - Individual Discovery Times (User Data Endpoints, by Topic):" << std::endl;
+    for (size_t i = 0; i < dt_t.size(); ++i) {
+      if (dt_t[i].count() == 0) {
+        continue;
+      }
+      std::cout << "   - " << topics.topics[i].name << ":" << std::endl;
+      dt_t[i].print_summary(std::cout, "     ", " (" + dt_t_max_conv[i]->writer_guid + " >> " + dt_t_max_conv[i]->reader_guid + ")");
+      if (show_histograms) {
+        dt_t[i].print_histogram(std::cout, "       ");
+      }
+    }
   }
-  std::cout << std::endl;
 
   std::cout << " - Global Discovery Stats:" << std::endl;
   std::cout << "   - Last New Conversation - Last New Participant = " << last_conversation_time - last_participant_time << std::endl;
   std::cout << "   - Last New Conversation - Last New Userdata Endpoint = " << last_conversation_time - last_userdata_endpoint_time << std::endl;
 
+  if (vm.count("export-endpoints") != 0u || vm.count("export-conversations") != 0u || vm.count("export-events") != 0u || vm.count("export-stats") != 0u) {
+    export_format format = EF_JSONL;
+    if (!parse_export_format(vm["export-format"].as<std::string>(), format)) {
+      std::cout << "Unknown export format " << vm["export-format"].as<std::string>() << " (expected jsonl or csv)" << std::endl;
+      return 1;
+    }
+    auto export_to = [&](const char* option, const char* what, const auto& write) {
+      if (vm.count(option) == 0u) {
+        return;
+      }
+      const std::string& export_filename = vm[option].as<std::string>();
+      std::ofstream ofs(export_filename.c_str(), std::ios::binary);
+      if (!ofs.good()) {
+        std::cout << "Unable to open " << what << " export file " << export_filename << std::endl;
+        return;
+      }
+      size_t rows = write(ofs);
+      std::cout << "Exported " << rows << " " << what << " rows to " << export_filename << std::endl;
+    };
+    export_to("export-endpoints", "endpoint", [&](std::ostream& os) { return export_endpoints(os, format, em, topics, domain); });
+    export_to("export-conversations", "conversation", [&](std::ostream& os) { return export_conversations(os, format, em, cm, topics, domain); });
+    export_to("export-events", "event", [&](std::ostream& os) { return export_events(os, format, cm, domain); });
+    export_to("export-stats", "stats", [&](std::ostream& os) {
+      return export_stats(os, format, {{"discovery_time", &dt}, {"builtin_discovery_time", &dt_b}, {"user_discovery_time", &dt_u},
+        {"ip_fragment_reconstruction_time", &ifs.reconstruction_times}, {"rtps_fragment_reassembly_time", &rfs.reassembly_times},
+        {"rtps_fragment_repair_time", &rfs.repair_times}});
+    });
+  }
+
+  if (vm.count("show-expected-matches") != 0u) {
+    expected_match_info emi;
+    gather_expected_matches(topics, cm, domain, frames.empty() ? 0.0 : frames.rbegin()->second.frame_reference_time, worst_count, emi);
+    print_expected_matches(std::cout, emi, topics, show_histograms);
+  }
+
+  if (vm.count("show-participant-matrix") != 0u || vm.count("participant-matrix") != 0u || vm.count("participant-matrix-csv") != 0u) {
+    participant_matrix pm;
+    gather_participant_matrix(em, cm, domain, pm);
+    if (vm.count("show-participant-matrix") != 0u) {
+      print_participant_matrix_summary(std::cout, pm);
+    }
+    if (vm.count("participant-matrix") != 0u) {
+      for (const auto & guid : vm["participant-matrix"].as<string_vec>()) {
+        print_participant_matrix_query(std::cout, pm, guid);
+      }
+    }
+    if (vm.count("participant-matrix-csv") != 0u) {
+      std::ofstream ofs(vm["participant-matrix-csv"].as<std::string>().c_str());
+      if (!ofs.good()) {
+        std::cout << "Unable to open participant matrix csv file " << vm["participant-matrix-csv"].as<std::string>() << std::endl;
+      } else {
+        write_participant_matrix_csv(ofs, pm);
+      }
+    }
+  }
+
+  if (vm.count("show-discovery-phases") != 0u) {
+    discovery_phase_info dpi;
+    gather_discovery_phase_info(em, cm, domain, dpi);
+    print_discovery_phase_stats(std::cout, dpi, worst_count, show_histograms);
+  }
+
+  if (vm.count("show-discovery-timeline") != 0u || vm.count("discovery-timeline-csv") != 0u) {
+    discovery_timeline_info dti;
+    gather_discovery_timeline_info(em, cm, domain, dti);
+    if (vm.count("show-discovery-timeline") != 0u) {
+      print_discovery_timeline_stats(std::cout, dti, worst_count, show_histograms);
+    }
+    if (vm.count("discovery-timeline-csv") != 0u) {
+      std::ofstream ofs(vm["discovery-timeline-csv"].as<std::string>().c_str());
+      if (!ofs.good()) {
+        std::cout << "Unable to open discovery timeline csv file " << vm["discovery-timeline-csv"].as<std::string>() << std::endl;
+      } else {
+        write_discovery_timeline_csv(ofs, dti);
+      }
+    }
+  }
+
+  if (vm.count("show-heartbeat-response") != 0u) {
+    heartbeat_response_map hrm;
+    gather_heartbeat_response_info(cm, domain, hrm);
+    print_heartbeat_response_stats(std::cout, hrm, worst_count, show_histograms);
+  }
+
+  if (vm.count("show-repair-stats") != 0u) {
+    repair_map rm;
+    gather_repair_info(cm, domain, rm);
+    print_repair_stats(std::cout, rm, worst_count, show_histograms);
+  }
+
+  if (vm.count("show-lifecycle") != 0u || vm.count("lifecycle-csv") != 0u) {
+    lifecycle_info li;
+    gather_lifecycle_info(em, cm, domain, li);
+    if (vm.count("show-lifecycle") != 0u) {
+      print_lifecycle_stats(std::cout, li, show_histograms);
+    }
+    if (vm.count("lifecycle-csv") != 0u) {
+      std::ofstream ofs(vm["lifecycle-csv"].as<std::string>().c_str());
+      if (!ofs.good()) {
+        std::cout << "Unable to open lifecycle csv file " << vm["lifecycle-csv"].as<std::string>() << std::endl;
+      } else {
+        write_active_conversations_csv(ofs, li);
+      }
+    }
+  }
+
+  if (vm.count("throughput") != 0u || vm.count("throughput-csv") != 0u || show_topics) {
+    throughput_info ti;
+    bool binned = gather_throughput_info(frames, em, domain, vm["throughput-bin"].as<double>(), ti);
+    if (binned && vm.count("throughput") != 0u) {
+      print_throughput_stats(std::cout, ti);
+    }
+    if (binned && vm.count("throughput-csv") != 0u) {
+      std::ofstream ofs(vm["throughput-csv"].as<std::string>().c_str());
+      if (!ofs.good()) {
+        std::cout << "Unable to open throughput csv file " << vm["throughput-csv"].as<std::string>() << std::endl;
+      } else {
+        write_throughput_csv(ofs, ti);
+      }
+    }
+    if (show_topics) {
+      std::vector<topic_stats> stats;
+      gather_topic_stats(topics, em, cm, ti, domain, stats);
+      print_topic_stats(std::cout, topics, stats);
+    }
+  }
+
   return 0;
 }
 
@@ -7,16 +7,16 @@
 net_info::net_info(std::string  m, std::string  i, std::string  p) : mac(std::move(m)), ip(std::move(i)), port(std::move(p)) {}
 
 std::ostream& operator<<(std::ostream& os, const net_info& info) {
-  return os << "( " << info.mac << ", " << info.ip << ", " << info.port << " )" << std::flush;
+  return os << "( " << info.mac << ", " << info.ip << ", " << info.port << " )";
 }
 
 std::ostream& operator<<(std::ostream& os, const std::map<std::string, net_info>& nm) {
-  os << "[ " << std::flush;
+  os << "[ ";
   if (!nm.empty()) {
-    std::cout << nm.begin()->second << std::flush;
-    std::for_each(++(nm.begin()), nm.end(), [&](const auto& v) { os << ", " << v.second << std::flush; });
+    os << nm.begin()->second;
+    std::for_each(++(nm.begin()), nm.end(), [&](const auto& v) { os << ", " << v.second; });
   }
-  return os << " ]" << std::flush;
+  return os << " ]";
 }
 
 bool merge_net_info(net_info& existing, const net_info& update) {
@@ -0,0 +1,154 @@
+#include "participant_matrix.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace {
+
+const size_t guid_prefix_length = 24;
+
+std::ostream& print_cell(std::ostream& os, const participant_matrix& pm, size_t row, size_t col) {
+  os << participant_pair_state_name(pm.state(row, col));
+  if (pm.complete(row, col)) {
+    os << " in " << std::fixed << std::setprecision(6) << pm.latency[pm.cell(row, col)] << " seconds";
+  }
+  return os;
+}
+
+}
+
+const char* participant_pair_state_name(participant_pair_state state) {
+  switch (state) {
+    case PPS_PARTIAL:
+      return "partial";
+    case PPS_COMPLETE:
+      return "complete";
+    case PPS_NONE:
+    default:
+      return "none";
+  }
+}
+
+participant_pair_state participant_matrix::state(size_t row, size_t col) const {
+  uint8_t mask = sedp_masks[cell(row, col)];
+  return mask == 3 ? PPS_COMPLETE : mask != 0 ? PPS_PARTIAL : PPS_NONE;
+}
+
+void gather_participant_matrix(const endpoint_map& em, const conversation_map& cm, uint16_t domain, participant_matrix& pm) {
+  for (const auto & it : em) {
+    const endpoint_info& info = it.second;
+    if ((domain != 0xFF && domain != info.domain_id) || info.guid.length() != 32 || info.guid.compare(guid_prefix_length, std::string::npos, "000100c2") != 0) {
+      continue;
+    }
+    pm.ids.emplace(info.guid.substr(0, guid_prefix_length), static_cast<uint32_t>(pm.prefixes.size()));
+    pm.prefixes.push_back(info.guid.substr(0, guid_prefix_length));
+    pm.spdp_times.push_back(info.spdp_announcements.empty() ? info.first_evidence_time : info.spdp_announcements.front().first->frame_reference_time);
+  }
+
+  const size_t n = pm.size();
+  pm.sedp_masks.assign(n * n, 0);
+  pm.latency.assign(n * n, 0.0);
+  pm.words_per_row = (n + 63) / 64;
+  pm.complete_bits.assign(n * pm.words_per_row, 0);
+
+  for (const auto & it : cm) {
+    const std::string& writer_guid = it.first;
+    if (writer_guid.length() != 32) {
+      continue;
+    }
+    uint8_t bit = writer_guid.compare(guid_prefix_length, std::string::npos, "000003c2") == 0 ? 1 : writer_guid.compare(guid_prefix_length, std::string::npos, "000004c2") == 0 ? 2 : 0;
+    auto wit = pm.ids.find(writer_guid.substr(0, guid_prefix_length));
+    if (bit == 0 || wit == pm.ids.end()) {
+      continue;
+    }
+    for (const auto & it2 : it.second) {
+      auto rit = pm.ids.find(it2.first.substr(0, guid_prefix_length));
+      if (rit == pm.ids.end() || rit->second == wit->second) {
+        continue;
+      }
+      size_t c = pm.cell(rit->second, wit->second);
+      pm.sedp_masks[c] |= bit;
+      pm.latency[c] = std::max(pm.latency[c], it2.second.first_evidence_time);
+    }
+  }
+
+  for (size_t row = 0; row < n; ++row) {
+    for (size_t col = 0; col < n; ++col) {
+      size_t c = pm.cell(row, col);
+      if (pm.sedp_masks[c] == 3) {
+        pm.latency[c] = std::max(pm.latency[c] - std::max(pm.spdp_times[row], pm.spdp_times[col]), 0.0);
+        pm.complete_bits[row * pm.words_per_row + col / 64] |= uint64_t(1) << (col % 64);
+      } else {
+        pm.latency[c] = 0.0;
+      }
+    }
+  }
+}
+
+void print_participant_matrix_summary(std::ostream& os, const participant_matrix& pm) {
+  const size_t n = pm.size();
+  size_t complete = 0;
+  size_t mutual = 0;
+  size_t partial = 0;
+  double slowest = 0.0;
+  size_t slowest_row = 0;
+  size_t slowest_col = 0;
+  for (size_t row = 0; row < n; ++row) {
+    for (size_t w = 0; w < pm.words_per_row; ++w) {
+      complete += static_cast<size_t>(__builtin_popcountll(pm.complete_bits[row * pm.words_per_row + w]));
+    }
+    for (size_t col = 0; col < n; ++col) {
+      partial += pm.state(row, col) == PPS_PARTIAL ? 1u : 0u;
+      mutual += (row < col && pm.complete(row, col) && pm.complete(col, row)) ? 1u : 0u;
+      if (pm.complete(row, col) && pm.latency[pm.cell(row, col)] > slowest) {
+        slowest = pm.latency[pm.cell(row, col)];
+        slowest_row = row;
+        slowest_col = col;
+      }
+    }
+  }
+  os << "Participant Matrix:" << std::endl;
+  os << " - Participants: " << n << std::endl;
+  os << " - Ordered pairs complete: " << complete << " of " << (n > 1 ? n * (n - 1) : 0) << " (partial: " << partial << ")" << std::endl;
+  os << " - Pairs that discovered each other: " << mutual << " of " << (n > 1 ? n * (n - 1) / 2 : 0) << std::endl;
+  if (complete != 0u) {
+    os << " - Slowest: " << pm.prefixes[slowest_row] << " discovered " << pm.prefixes[slowest_col] << " in " << std::fixed << std::setprecision(6) << slowest << " seconds" << std::endl;
+  }
+}
+
+bool print_participant_matrix_query(std::ostream& os, const participant_matrix& pm, const std::string& guid) {
+  auto it = pm.ids.find(guid.substr(0, guid_prefix_length));
+  if (it == pm.ids.end()) {
+    os << "Participant " << guid << " not found in participant matrix" << std::endl;
+    return false;
+  }
+  size_t self = it->second;
+  os << "Participant Matrix for " << pm.prefixes[self] << ":" << std::endl;
+  for (size_t peer = 0; peer < pm.size(); ++peer) {
+    if (peer == self) {
+      continue;
+    }
+    os << " - " << pm.prefixes[peer] << " :: discovered by it: ";
+    print_cell(os, pm, self, peer) << ", discovered it: ";
+    print_cell(os, pm, peer, self) << std::endl;
+  }
+  return true;
+}
+
+void write_participant_matrix_csv(std::ostream& os, const participant_matrix& pm) {
+  os << "participant,peer,state,latency\n";
+  os << std::fixed << std::setprecision(6);
+  for (size_t row = 0; row < pm.size(); ++row) {
+    for (size_t col = 0; col < pm.size(); ++col) {
+      if (row == col) {
+        continue;
+      }
+      os << pm.prefixes[row] << ',' << pm.prefixes[col] << ',' << participant_pair_state_name(pm.state(row, col)) << ',';
+      if (pm.complete(row, col)) {
+        os << pm.latency[pm.cell(row, col)];
+      }
+      os << '\n';
+    }
+  }
+  os << std::flush;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "conversation_info.hpp"
+#include "endpoint_info.hpp"
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum participant_pair_state : uint8_t {
+  PPS_NONE,     // no SEDP traffic from the peer's builtin writers seen
+  PPS_PARTIAL,  // only one of the peer's SEDP (publications / subscriptions) writers reached the participant
+  PPS_COMPLETE  // both of the peer's SEDP writers reached the participant
+};
+
+const char* participant_pair_state_name(participant_pair_state state);
+
+// Directional participant x participant matrix over dense participant ids: cell (i, j) describes participant i
+// discovering participant j, i.e. j's SEDP writers conversing with i's SEDP readers. Cells are kept in flat row-major
+// arrays, and each row also keeps a bitset of the peers it discovered completely.
+struct participant_matrix {
+  std::vector<std::string> prefixes; // indexed by dense id
+  std::unordered_map<std::string, uint32_t> ids;
+  std::vector<uint8_t> sedp_masks; // bit 0: publications, bit 1: subscriptions
+  std::vector<double> latency; // later participant's first SPDP announcement to the last of the SEDP conversations forming
+  std::vector<double> spdp_times;
+  std::vector<uint64_t> complete_bits; // row-major, words_per_row words per participant
+  size_t words_per_row{0};
+
+  size_t size() const {
+    return prefixes.size();
+  }
+  size_t cell(size_t row, size_t col) const {
+    return row * prefixes.size() + col;
+  }
+  participant_pair_state state(size_t row, size_t col) const;
+  bool complete(size_t row, size_t col) const {
+    return (complete_bits[row * words_per_row + col / 64] & (uint64_t(1) << (col % 64))) != 0u;
+  }
+};
+
+void gather_participant_matrix(const endpoint_map& em, const conversation_map& cm, uint16_t domain, participant_matrix& pm);
+void print_participant_matrix_summary(std::ostream& os, const participant_matrix& pm);
+
+// Prints how the participant discovered each peer (its row) and how each peer discovered it (its column)
+bool print_participant_matrix_query(std::ostream& os, const participant_matrix& pm, const std::string& guid);
+
+// Long ("participant,peer,state,latency") format, one line per ordered pair, which heatmap tools pivot directly
+void write_participant_matrix_csv(std::ostream& os, const participant_matrix& pm);
@@ -0,0 +1,149 @@
+#include "pcap_export.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+
+namespace {
+
+const size_t global_header_size = 24;
+const size_t record_header_size = 16;
+
+// Anything larger is taken as a sign of a corrupt file rather than a real packet
+const uint32_t max_record_size = 1u << 28;
+
+// Timestamps in the text dump are printed to the nanosecond, but pcap keeps only microseconds in the common case
+const double max_time_difference = 1e-3;
+
+uint32_t read_u32(const unsigned char* p, bool swapped) {
+  if (swapped) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+  }
+  return (static_cast<uint32_t>(p[3]) << 24) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | static_cast<uint32_t>(p[0]);
+}
+
+}
+
+bool index_pcap(const std::string& filename, pcap_index& index) {
+  index.filename = filename;
+  index.records.clear();
+
+  std::ifstream ifs(filename.c_str(), std::ios::binary);
+  if (!ifs.good()) {
+    std::cout << "Unable to open pcap file " << filename << std::endl;
+    return false;
+  }
+
+  unsigned char header[global_header_size] = {};
+  ifs.read(reinterpret_cast<char*>(header), global_header_size);
+  size_t header_length = static_cast<size_t>(ifs.gcount());
+  bool swapped = false;
+  bool nanoseconds = false;
+  uint32_t magic = read_u32(header, false);
+  if (magic == 0xa1b2c3d4u || magic == 0xa1b23c4du) {
+    nanoseconds = magic == 0xa1b23c4du;
+  } else if (magic == 0xd4c3b2a1u || magic == 0x4d3cb2a1u) {
+    swapped = true;
+    nanoseconds = magic == 0x4d3cb2a1u;
+  } else if (magic == 0x0a0d0d0au) {
+    std::cout << "Pcap file " << filename << " is pcapng; convert it first (e.g. editcap -F pcap)" << std::endl;
+    return false;
+  } else {
+    std::cout << "Pcap file " << filename << " doesn't start with a pcap header" << std::endl;
+    return false;
+  }
+  if (header_length < global_header_size) {
+    std::cout << "Pcap file " << filename << " is too short for a pcap header" << std::endl;
+    return false;
+  }
+  index.header.assign(reinterpret_cast<const char*>(header), global_header_size);
+  index.link_type = read_u32(header + 20, swapped);
+  double frac_scale = nanoseconds ? 1e-9 : 1e-6;
+
+  uint64_t offset = global_header_size;
+  unsigned char record[record_header_size];
+  while (ifs.read(reinterpret_cast<char*>(record), record_header_size)) {
+    uint32_t incl_len = read_u32(record + 8, swapped);
+    if (incl_len > max_record_size) {
+      std::cout << "Pcap file " << filename << " has a corrupt record header at offset " << offset << std::endl;
+      return false;
+    }
+    double epoch_time = static_cast<double>(read_u32(record, swapped)) + static_cast<double>(read_u32(record + 4, swapped)) * frac_scale;
+    index.records.push_back(pcap_record{offset, static_cast<uint32_t>(record_header_size) + incl_len, epoch_time});
+    offset += record_header_size + incl_len;
+    ifs.seekg(static_cast<std::streamoff>(offset));
+  }
+  if (ifs.gcount() != 0) {
+    std::cout << "Pcap file " << filename << " ends with a truncated record header" << std::endl;
+  }
+  return true;
+}
+
+bool write_pcap_frames(const std::vector<pcap_index>& indexes, const std::vector<pcap_frame_ref>& frames, const std::string& out_filename) {
+  std::set<size_t> used;
+  for (const auto & ref : frames) {
+    if (ref.file_index >= indexes.size()) {
+      std::cout << "No pcap file given for frame " << ref.frame_no << " of input file " << ref.file_index + 1 << std::endl;
+      return false;
+    }
+    const pcap_index& index = indexes[ref.file_index];
+    if (ref.frame_no == 0 || ref.frame_no > index.records.size()) {
+      std::cout << "Frame " << ref.frame_no << " is not in pcap file " << index.filename << " (" << index.records.size() << " records)" << std::endl;
+      return false;
+    }
+    const pcap_record& rec = index.records[ref.frame_no - 1];
+    if (ref.epoch_time >= 0.0 && std::fabs(rec.epoch_time - ref.epoch_time) > max_time_difference) {
+      std::cout << "Frame " << ref.frame_no << " of pcap file " << index.filename << " doesn't match the text dump (timestamps differ)" << std::endl;
+      return false;
+    }
+    used.insert(ref.file_index);
+  }
+  // The magic number carries byte order and timestamp resolution, so it has to agree along with the link type
+  for (size_t i : used) {
+    if (indexes[i].header.compare(0, 4, indexes[*used.begin()].header, 0, 4) != 0 || indexes[i].link_type != indexes[*used.begin()].link_type) {
+      std::cout << "Pcap files " << indexes[*used.begin()].filename << " and " << indexes[i].filename << " differ in byte order, timestamp resolution or link type" << std::endl;
+      return false;
+    }
+  }
+
+  std::vector<std::ifstream> inputs(indexes.size());
+  for (size_t i : used) {
+    inputs[i].open(indexes[i].filename.c_str(), std::ios::binary);
+    if (!inputs[i].good()) {
+      std::cout << "Unable to open pcap file " << indexes[i].filename << std::endl;
+      return false;
+    }
+  }
+  // Records are copied into a temporary file that only replaces out_filename once everything was written
+  const std::string tmp_filename = out_filename + ".tmp";
+  std::ofstream ofs(tmp_filename.c_str(), std::ios::binary);
+  if (!ofs.good()) {
+    std::cout << "Unable to open pcap output file " << tmp_filename << std::endl;
+    return false;
+  }
+
+  ofs << (used.empty() ? indexes.front().header : indexes[*used.begin()].header);
+  std::vector<char> buffer;
+  for (const auto & ref : frames) {
+    const pcap_record& rec = indexes[ref.file_index].records[ref.frame_no - 1];
+    buffer.resize(rec.length);
+    std::ifstream& in = inputs[ref.file_index];
+    in.seekg(static_cast<std::streamoff>(rec.offset));
+    if (!in.read(buffer.data(), static_cast<std::streamsize>(rec.length))) {
+      std::cout << "Pcap file " << indexes[ref.file_index].filename << " is truncated in frame " << ref.frame_no << std::endl;
+      ofs.close();
+      std::remove(tmp_filename.c_str());
+      return false;
+    }
+    ofs.write(buffer.data(), static_cast<std::streamsize>(rec.length));
+  }
+  ofs.close();
+  if (ofs.fail() || std::rename(tmp_filename.c_str(), out_filename.c_str()) != 0) {
+    std::cout << "Unable to write pcap output file " << out_filename << std::endl;
+    std::remove(tmp_filename.c_str());
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Where one record (16 byte record header plus captured bytes) sits in a classic libpcap file
+struct pcap_record {
+  uint64_t offset;
+  uint32_t length;
+  double epoch_time;
+};
+
+struct pcap_index {
+  std::string filename;
+  std::string header; // 24 byte global header, copied verbatim into exported files
+  uint32_t link_type{0};
+  std::vector<pcap_record> records; // records[i] holds frame i + 1, as numbered by tshark
+};
+
+// Frame to export: which of the indexed files it comes from and its 1-based frame number there. When epoch_time is
+// known (not negative) it is checked against the record's timestamp to catch a pcap that doesn't match the text dump.
+struct pcap_frame_ref {
+  size_t file_index;
+  size_t frame_no;
+  double epoch_time;
+};
+
+// Walks the record headers of a classic pcap file (either byte order, micro- or nanosecond timestamps) without
+// reading packet data. pcapng files are rejected: their blocks can't be copied into a classic pcap file as-is.
+bool index_pcap(const std::string& filename, pcap_index& index);
+
+// Copies the records of frames, in the order given, byte for byte into a new pcap file. All files referenced must share
+// byte order, timestamp resolution and link type; out_filename is left untouched if a frame is missing, doesn't match
+// or can't be read, since the copy goes to a temporary file that is only renamed over it on success.
+bool write_pcap_frames(const std::vector<pcap_index>& indexes, const std::vector<pcap_frame_ref>& frames, const std::string& out_filename);
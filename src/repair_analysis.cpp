@@ -0,0 +1,177 @@
+#include "repair_analysis.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+enum repair_event_kind : uint8_t {
+  REK_DATA,
+  REK_GAP,
+  REK_ACKNACK
+};
+
+struct repair_event {
+  const rtps_frame* frame;
+  size_t sm_order;
+  repair_event_kind kind;
+  size_t index;
+};
+
+double percent(size_t part, size_t whole) {
+  return whole == 0 ? 0.0 : 100.0 * static_cast<double>(part) / static_cast<double>(whole);
+}
+
+void close_pending(std::map<size_t, double>::iterator it, double now, size_t& repair_count, repair_info& info) {
+  info.repair_times.record(now - it->second);
+  ++repair_count;
+}
+
+}
+
+void gather_repair_info(const conversation_map& cm, uint16_t domain, repair_map& rm) {
+  for (const auto & it : cm) {
+    for (const auto & it2 : it.second) {
+      const conversation_info& conv = it2.second;
+      if ((domain != 0xFF && domain != conv.domain_id) || conv.acknacks.empty()) {
+        continue;
+      }
+
+      // conv.datas also holds the SPDP / SEDP announcements relevant to the conversation, so keep only the writer's own traffic
+      std::vector<repair_event> events;
+      for (size_t i = 0; i < conv.datas.size(); ++i) {
+        const auto& v = conv.datas[i];
+        if (v.first->guid_prefix + v.second->writer_id == conv.writer_guid) {
+          events.push_back(repair_event{v.first, v.second->sm_order, REK_DATA, i});
+        }
+      }
+      for (size_t i = 0; i < conv.gaps.size(); ++i) {
+        const auto& v = conv.gaps[i];
+        if (v.first->guid_prefix + v.second->writer_id == conv.writer_guid) {
+          events.push_back(repair_event{v.first, v.second->sm_order, REK_GAP, i});
+        }
+      }
+      for (size_t i = 0; i < conv.acknacks.size(); ++i) {
+        events.push_back(repair_event{conv.acknacks[i].first, conv.acknacks[i].second->sm_order, REK_ACKNACK, i});
+      }
+      std::sort(events.begin(), events.end(), [](const repair_event& a, const repair_event& b) {
+        return a.frame->frame_no < b.frame->frame_no || (a.frame->frame_no == b.frame->frame_no && a.sm_order < b.sm_order);
+      });
+
+      repair_info& info = rm[conv.writer_guid][conv.reader_guid];
+      info.writer_guid = conv.writer_guid;
+      info.reader_guid = conv.reader_guid;
+      info.domain_id = conv.domain_id;
+
+      std::map<size_t, double> pending; // nacked sequence number -> time of first nack
+      std::unordered_map<size_t, uint32_t> sent;
+      size_t last_data_frame = 0;
+      size_t last_retransmission_frame = 0;
+
+      for (const auto & ev : events) {
+        double now = ev.frame->frame_reference_time;
+        if (ev.kind == REK_ACKNACK) {
+          const rtps_acknack& acknack = *(conv.acknacks[ev.index].second);
+          acknack.bitmap.for_each([&](size_t seq) {
+            if (pending.emplace(seq, now).second) {
+              ++info.nacked_count;
+            }
+          });
+        } else if (ev.kind == REK_DATA) {
+          const rtps_data& data = *(conv.datas[ev.index].second);
+          // Several submessages may share a frame, so only count each frame's udp_length once
+          if (ev.frame->frame_no != last_data_frame) {
+            info.data_bytes += ev.frame->udp_length;
+            last_data_frame = ev.frame->frame_no;
+          }
+          uint32_t& times_sent = sent[data.writer_seq_num];
+          if (++times_sent > 1) {
+            if (times_sent == 2) {
+              ++info.resent_sample_count;
+            }
+            if (ev.frame->frame_no != last_retransmission_frame) {
+              info.retransmission_bytes += ev.frame->udp_length;
+              last_retransmission_frame = ev.frame->frame_no;
+            }
+          }
+          auto pit = pending.find(data.writer_seq_num);
+          if (pit != pending.end()) {
+            close_pending(pit, now, info.data_repair_count, info);
+            pending.erase(pit);
+          }
+        } else {
+          const rtps_gap& gap = *(conv.gaps[ev.index].second);
+          // Everything in [gapStart, bitmapBase) is irrelevant, as is every sequence number set in the gap list
+          auto pit = pending.lower_bound(gap.gap_start);
+          while (pit != pending.end() && pit->first < gap.bitmap.base) {
+            close_pending(pit, now, info.gap_repair_count, info);
+            pit = pending.erase(pit);
+          }
+          gap.bitmap.for_each([&](size_t seq) {
+            auto git = pending.find(seq);
+            if (git != pending.end()) {
+              close_pending(git, now, info.gap_repair_count, info);
+              pending.erase(git);
+            }
+          });
+        }
+      }
+      info.unrepaired_count = pending.size();
+      info.sample_count = sent.size();
+    }
+  }
+}
+
+void print_repair_stats(std::ostream& os, const repair_map& rm, size_t worst_count, bool show_histograms) {
+  hdr_histogram all_repair_times;
+  repair_info totals;
+  std::vector<const repair_info*> ranked;
+
+  for (const auto & it : rm) {
+    for (const auto & it2 : it.second) {
+      const repair_info& info = it2.second;
+      all_repair_times.merge(info.repair_times);
+      totals.nacked_count += info.nacked_count;
+      totals.data_repair_count += info.data_repair_count;
+      totals.gap_repair_count += info.gap_repair_count;
+      totals.unrepaired_count += info.unrepaired_count;
+      totals.sample_count += info.sample_count;
+      totals.resent_sample_count += info.resent_sample_count;
+      totals.data_bytes += info.data_bytes;
+      totals.retransmission_bytes += info.retransmission_bytes;
+      ranked.push_back(&info);
+    }
+  }
+
+  os << "NACK Repair Stats:" << std::endl;
+  os << " - Conversations with acknacks: " << ranked.size() << std::endl;
+  os << " - Nacked sequence numbers: " << totals.nacked_count << " (repaired by data: " << totals.data_repair_count
+     << ", repaired by gap: " << totals.gap_repair_count << ", unrepaired: " << totals.unrepaired_count << ")" << std::endl;
+  os << " - Repair Times:" << std::endl;
+  all_repair_times.print_summary(os, "   ");
+  if (show_histograms) {
+    all_repair_times.print_histogram(os, "     ");
+  }
+  os << " - Samples sent: " << totals.sample_count << ", sent more than once: " << totals.resent_sample_count
+     << " (" << std::fixed << std::setprecision(2) << percent(totals.resent_sample_count, totals.sample_count) << "%)" << std::endl;
+  os << " - Data bytes sent: " << totals.data_bytes << ", retransmission bytes: " << totals.retransmission_bytes
+     << " (" << percent(totals.retransmission_bytes, totals.data_bytes) << "%)" << std::endl;
+
+  size_t shown = std::min(worst_count, ranked.size());
+  std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(shown), ranked.end(), [](const repair_info* a, const repair_info* b) {
+    return a->retransmission_bytes > b->retransmission_bytes;
+  });
+
+  os << " - Most Retransmission Bytes by Conversation:" << std::endl;
+  for (size_t i = 0; i < shown; ++i) {
+    const repair_info& info = *ranked[i];
+    os << "   - " << info.writer_guid << " >> " << info.reader_guid << " :: nacked = " << info.nacked_count
+       << ", unrepaired = " << info.unrepaired_count << ", resent samples = " << info.resent_sample_count
+       << ", retransmission bytes = " << info.retransmission_bytes << " of " << info.data_bytes
+       << " (" << std::fixed << std::setprecision(2) << percent(info.retransmission_bytes, info.data_bytes) << "%)"
+       << std::setprecision(6) << ", p99 repair = " << info.repair_times.percentile(99.0) << '\n';
+  }
+  os << std::flush;
+}
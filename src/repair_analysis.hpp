@@ -0,0 +1,29 @@
+#pragma once
+
+#include "conversation_info.hpp"
+#include "hdr_histogram.hpp"
+
+#include <map>
+#include <ostream>
+#include <string>
+
+struct repair_info {
+  std::string writer_guid;
+  std::string reader_guid;
+  uint16_t domain_id{0xFF};
+  size_t nacked_count{0};
+  size_t data_repair_count{0};
+  size_t gap_repair_count{0};
+  size_t unrepaired_count{0};
+  size_t sample_count{0};
+  size_t resent_sample_count{0};
+  size_t data_bytes{0};
+  size_t retransmission_bytes{0};
+  hdr_histogram repair_times;
+};
+
+using repair_map = std::map<std::string, std::map<std::string, repair_info>>;
+
+// Replays each conversation's acknacks, datas and gaps in capture order, timing every nacked sequence number until a DATA or GAP covers it
+void gather_repair_info(const conversation_map& cm, uint16_t domain, repair_map& rm);
+void print_repair_stats(std::ostream& os, const repair_map& rm, size_t worst_count, bool show_histograms);
@@ -0,0 +1,167 @@
+#include "rtps_fragments.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <iomanip>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct sample_reassembly {
+  std::string writer_guid;
+  double first_time{0.0};
+  size_t total_fragments{0};
+  size_t received_count{0};
+  std::vector<bool> received;
+  std::map<size_t, double> nacked; // fragment number -> time of first NACK_FRAG
+  bool complete{false};
+};
+
+void retire(const sample_reassembly& sr, bool evicted, rtps_fragment_stats& stats) {
+  if (!sr.complete) {
+    size_t missing = sr.total_fragments - sr.received_count;
+    rtps_fragment_writer_stats& ws = stats.writers[sr.writer_guid];
+    ++stats.incomplete_count;
+    ++ws.incomplete_count;
+    stats.missing_fragment_count += missing;
+    ws.missing_fragment_count += missing;
+    if (evicted) {
+      ++stats.evicted_count;
+    }
+  }
+  stats.unrepaired_fragment_count += sr.nacked.size();
+}
+
+}
+
+void gather_rtps_fragment_stats(const rtps_frame_map& frames, uint16_t domain, size_t table_limit, rtps_fragment_stats& stats) {
+  stats.domain = domain;
+  stats.table_limit = std::max(table_limit, size_t(1));
+  std::unordered_map<std::string, sample_reassembly> table;
+  std::deque<std::string> insertion_order;
+
+  for (const auto & it : frames) {
+    const rtps_frame& frame = it.second;
+    if (domain != 0xFF && domain != frame.domain_id) {
+      continue;
+    }
+    double now = frame.frame_reference_time;
+
+    for (const auto & data_frag : frame.data_frag_vec) {
+      ++stats.data_frag_count;
+      std::string writer_guid = frame.guid_prefix + data_frag.writer_id;
+      std::string key = writer_guid + ":" + std::to_string(data_frag.writer_seq_num);
+      auto sit = table.find(key);
+      if (sit == table.end()) {
+        if (table.size() >= stats.table_limit) {
+          auto oldest = table.find(insertion_order.front());
+          retire(oldest->second, true, stats);
+          table.erase(oldest);
+          insertion_order.pop_front();
+        }
+        sample_reassembly& sr = table[key];
+        sr.writer_guid = writer_guid;
+        sr.first_time = now;
+        sr.total_fragments = std::max((data_frag.sample_size + data_frag.fragment_size - 1) / data_frag.fragment_size, size_t(1));
+        sr.received.assign(sr.total_fragments, false);
+        insertion_order.push_back(key);
+        ++stats.sample_count;
+        ++stats.writers[writer_guid].sample_count;
+        sit = table.find(key);
+      }
+
+      sample_reassembly& sr = sit->second;
+      size_t last = data_frag.fragment_starting_num + std::max(data_frag.fragments_in_submessage, size_t(1));
+      for (size_t fn = data_frag.fragment_starting_num; fn < last && fn <= sr.total_fragments; ++fn) {
+        ++stats.fragment_count;
+        auto nit = sr.nacked.find(fn);
+        if (nit != sr.nacked.end()) {
+          stats.repair_times.record(now - nit->second);
+          ++stats.repaired_fragment_count;
+          sr.nacked.erase(nit);
+        }
+        if (sr.received[fn - 1]) {
+          ++stats.duplicate_fragment_count;
+        } else {
+          sr.received[fn - 1] = true;
+          ++sr.received_count;
+        }
+      }
+      if (!sr.complete && sr.received_count == sr.total_fragments) {
+        sr.complete = true;
+        ++stats.completed_count;
+        stats.reassembly_times.record(now - sr.first_time);
+      }
+    }
+
+    stats.heartbeat_frag_count += frame.heartbeat_frag_vec.size();
+
+    for (const auto & nack_frag : frame.nack_frag_vec) {
+      ++stats.nack_frag_count;
+      auto idit = find_previous_dst(frame, nack_frag.sm_order);
+      if (idit == frame.info_dst_vec.end()) {
+        continue;
+      }
+      std::string writer_guid = idit->guid_prefix + nack_frag.writer_id;
+      auto sit = table.find(writer_guid + ":" + std::to_string(nack_frag.writer_seq_num));
+      if (sit == table.end()) {
+        // The sample was never seen (or already evicted), so any request for it stays unanswered as far as we can tell
+        size_t requested = nack_frag.fragment_state.count();
+        stats.nacked_fragment_count += requested;
+        stats.unrepaired_fragment_count += requested;
+        stats.writers[writer_guid].nacked_fragment_count += requested;
+        continue;
+      }
+      sample_reassembly& sr = sit->second;
+      nack_frag.fragment_state.for_each([&](size_t fn) {
+        if (sr.nacked.emplace(fn, now).second) {
+          ++stats.nacked_fragment_count;
+          ++stats.writers[writer_guid].nacked_fragment_count;
+        }
+      });
+    }
+  }
+
+  for (const auto & it : table) {
+    retire(it.second, false, stats);
+  }
+}
+
+void print_rtps_fragment_stats(std::ostream& os, const rtps_fragment_stats& stats, size_t worst_count, bool show_histograms) {
+  os << "RTPS Fragmentation Stats" << (stats.domain == 0xFF ? std::string(" (all domains)") : " (domain " + std::to_string(static_cast<unsigned>(stats.domain)) + ")") << ":" << std::endl;
+  os << " - Submessages: DATA_FRAG = " << stats.data_frag_count << ", HEARTBEAT_FRAG = " << stats.heartbeat_frag_count << ", NACK_FRAG = " << stats.nack_frag_count << std::endl;
+  os << " - Fragmented samples: " << stats.sample_count << " (completed: " << stats.completed_count << ", incomplete: " << stats.incomplete_count
+     << ", evicted from reassembly table of " << stats.table_limit << ": " << stats.evicted_count << ")" << std::endl;
+  os << " - Fragments: " << stats.fragment_count << " (repeated: " << stats.duplicate_fragment_count << "), missing from incomplete samples: " << stats.missing_fragment_count << std::endl;
+  os << " - Fragments requested by NACK_FRAG: " << stats.nacked_fragment_count << " (repaired: " << stats.repaired_fragment_count << ", unrepaired: " << stats.unrepaired_fragment_count << ")" << std::endl;
+  os << " - Individual Reassembly Times:" << std::endl;
+  stats.reassembly_times.print_summary(os, "   ");
+  if (show_histograms) {
+    stats.reassembly_times.print_histogram(os, "     ");
+  }
+  os << " - NACK_FRAG Repair Times:" << std::endl;
+  stats.repair_times.print_summary(os, "   ");
+  if (show_histograms) {
+    stats.repair_times.print_histogram(os, "     ");
+  }
+
+  std::vector<std::pair<std::string, rtps_fragment_writer_stats>> ranked;
+  std::copy_if(stats.writers.begin(), stats.writers.end(), std::back_inserter(ranked), [](const auto& v) {
+    return v.second.incomplete_count != 0u || v.second.nacked_fragment_count != 0u;
+  });
+  size_t shown = std::min(worst_count, ranked.size());
+  std::partial_sort(ranked.begin(), ranked.begin() + static_cast<std::ptrdiff_t>(shown), ranked.end(), [](const auto& a, const auto& b) {
+    if (a.second.incomplete_count != b.second.incomplete_count) {
+      return a.second.incomplete_count > b.second.incomplete_count;
+    }
+    return a.second.nacked_fragment_count > b.second.nacked_fragment_count;
+  });
+  os << " - Writers With Incomplete or Nacked Samples:" << std::endl;
+  for (size_t i = 0; i < shown; ++i) {
+    const rtps_fragment_writer_stats& ws = ranked[i].second;
+    os << "   - " << ranked[i].first << " :: samples = " << ws.sample_count << ", incomplete = " << ws.incomplete_count
+       << ", missing fragments = " << ws.missing_fragment_count << ", nacked fragments = " << ws.nacked_fragment_count << '\n';
+  }
+  os << std::flush;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "frames.hpp"
+#include "hdr_histogram.hpp"
+
+#include <map>
+#include <ostream>
+#include <string>
+
+struct rtps_fragment_writer_stats {
+  size_t sample_count{0};
+  size_t incomplete_count{0};
+  size_t missing_fragment_count{0};
+  size_t nacked_fragment_count{0};
+};
+
+struct rtps_fragment_stats {
+  uint16_t domain{0xFF};
+  size_t table_limit{0};
+  size_t data_frag_count{0};
+  size_t heartbeat_frag_count{0};
+  size_t nack_frag_count{0};
+  size_t fragment_count{0};
+  size_t duplicate_fragment_count{0};
+  size_t sample_count{0};
+  size_t completed_count{0};
+  size_t incomplete_count{0};
+  size_t evicted_count{0};
+  size_t missing_fragment_count{0};
+  size_t nacked_fragment_count{0};
+  size_t repaired_fragment_count{0};
+  size_t unrepaired_fragment_count{0};
+  hdr_histogram reassembly_times;
+  hdr_histogram repair_times;
+  std::map<std::string, rtps_fragment_writer_stats> writers;
+};
+
+// Tracks DATA_FRAG reassembly per (writer, seq) in a table of at most table_limit samples, evicting the oldest sample
+// once full (evicted samples that were still incomplete count as incomplete). NACK_FRAG requests are timed until the
+// requested fragment is seen again.
+void gather_rtps_fragment_stats(const rtps_frame_map& frames, uint16_t domain, size_t table_limit, rtps_fragment_stats& stats);
+void print_rtps_fragment_stats(std::ostream& os, const rtps_fragment_stats& stats, size_t worst_count, bool show_histograms);
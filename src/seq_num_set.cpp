@@ -0,0 +1,149 @@
+#include "seq_num_set.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include <algorithm>
+
+namespace {
+
+using word_array = std::array<uint64_t, seq_num_set::WORD_COUNT>;
+
+// Moves every bit up by shift positions (towards higher sequence numbers), discarding what falls off the end
+word_array shift_up(const word_array& in, size_t shift) {
+  word_array out{{0, 0, 0, 0}};
+  if (shift >= seq_num_set::MAX_BITS) {
+    return out;
+  }
+  size_t word_shift = shift / 64;
+  auto bit_shift = static_cast<unsigned>(shift % 64);
+  for (size_t w = seq_num_set::WORD_COUNT; w-- > word_shift;) {
+    out[w] = in[w - word_shift] << bit_shift;
+    if (bit_shift != 0u && w > word_shift) {
+      out[w] |= in[w - word_shift - 1] >> (64u - bit_shift);
+    }
+  }
+  return out;
+}
+
+// All 256 bits fit a single AVX2 register (or two SSE2 registers), so set operations are one or two instructions
+word_array combine_or(const word_array& a, const word_array& b) {
+  word_array out;
+#if defined(__AVX2__)
+  __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.data()));
+  __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.data()));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.data()), _mm256_or_si256(va, vb));
+#elif defined(__SSE2__)
+  for (size_t w = 0; w < seq_num_set::WORD_COUNT; w += 2) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data() + w));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data() + w));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out.data() + w), _mm_or_si128(va, vb));
+  }
+#else
+  for (size_t w = 0; w < seq_num_set::WORD_COUNT; ++w) {
+    out[w] = a[w] | b[w];
+  }
+#endif
+  return out;
+}
+
+word_array combine_and(const word_array& a, const word_array& b) {
+  word_array out;
+#if defined(__AVX2__)
+  __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a.data()));
+  __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.data()));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(out.data()), _mm256_and_si256(va, vb));
+#elif defined(__SSE2__)
+  for (size_t w = 0; w < seq_num_set::WORD_COUNT; w += 2) {
+    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a.data() + w));
+    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b.data() + w));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out.data() + w), _mm_and_si128(va, vb));
+  }
+#else
+  for (size_t w = 0; w < seq_num_set::WORD_COUNT; ++w) {
+    out[w] = a[w] & b[w];
+  }
+#endif
+  return out;
+}
+
+void align(const seq_num_set& a, const seq_num_set& b, seq_num_set& out, word_array& wa, word_array& wb) {
+  out.base = std::min(a.base, b.base);
+  out.num_bits = std::min(std::max(a.base + a.num_bits, b.base + b.num_bits) - out.base, seq_num_set::MAX_BITS);
+  wa = shift_up(a.words, a.base - out.base);
+  wb = shift_up(b.words, b.base - out.base);
+}
+
+}
+
+const size_t seq_num_set::MAX_BITS;
+const size_t seq_num_set::WORD_COUNT;
+
+void seq_num_set::parse(size_t bitmap_base, const std::string& bitmap) {
+  base = bitmap_base;
+  num_bits = 0;
+  words.fill(0);
+  for (size_t i = 0; i < bitmap.size() && num_bits < MAX_BITS; ++i) {
+    if (bitmap[i] == '1') {
+      words[num_bits / 64] |= uint64_t(1) << (num_bits % 64);
+    } else if (bitmap[i] != '0') {
+      continue;
+    }
+    ++num_bits;
+  }
+}
+
+bool seq_num_set::empty() const {
+  return (words[0] | words[1] | words[2] | words[3]) == 0u;
+}
+
+bool seq_num_set::contains(size_t seq) const {
+  if (seq < base || seq - base >= num_bits) {
+    return false;
+  }
+  size_t i = seq - base;
+  return ((words[i / 64] >> (i % 64)) & 1u) != 0u;
+}
+
+void seq_num_set::insert(size_t seq) {
+  if (seq >= base && seq - base < MAX_BITS) {
+    size_t i = seq - base;
+    words[i / 64] |= uint64_t(1) << (i % 64);
+    num_bits = std::max(num_bits, i + 1);
+  }
+}
+
+size_t seq_num_set::count() const {
+  size_t result = 0;
+  for (uint64_t w : words) {
+    result += static_cast<size_t>(__builtin_popcountll(w));
+  }
+  return result;
+}
+
+seq_num_set seq_num_set_union(const seq_num_set& a, const seq_num_set& b) {
+  seq_num_set result;
+  word_array wa;
+  word_array wb;
+  align(a, b, result, wa, wb);
+  result.words = combine_or(wa, wb);
+  return result;
+}
+
+seq_num_set seq_num_set_intersection(const seq_num_set& a, const seq_num_set& b) {
+  seq_num_set result;
+  word_array wa;
+  word_array wb;
+  align(a, b, result, wa, wb);
+  result.words = combine_and(wa, wb);
+  return result;
+}
+
+std::ostream& operator<<(std::ostream& os, const seq_num_set& sns) {
+  std::string bits(sns.num_bits, '0');
+  sns.for_each([&](size_t seq) { bits[seq - sns.base] = '1'; });
+  return os << bits;
+}
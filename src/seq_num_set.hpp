@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Sequence number set as carried by ACKNACK and GAP submessages: bit i stands for base + i, for up to 256 bits.
+// Bits are stored least significant first within each word so set members can be walked with count-trailing-zeros.
+struct seq_num_set {
+  static const size_t MAX_BITS = 256;
+  static const size_t WORD_COUNT = MAX_BITS / 64;
+
+  size_t base{0};
+  size_t num_bits{0};
+  std::array<uint64_t, WORD_COUNT> words{{0, 0, 0, 0}};
+
+  // Decodes the tshark display form of a bitmap ("0110..."); characters other than '0' and '1' are skipped
+  void parse(size_t bitmap_base, const std::string& bitmap);
+
+  bool empty() const;
+  bool contains(size_t seq) const;
+  void insert(size_t seq);
+  size_t count() const;
+
+  // Calls f(seq) for every member in increasing order
+  template <typename F>
+  void for_each(F f) const {
+    for (size_t w = 0; w < WORD_COUNT; ++w) {
+      uint64_t bits = words[w];
+      while (bits != 0u) {
+        f(base + w * 64 + static_cast<size_t>(__builtin_ctzll(bits)));
+        bits &= bits - 1;
+      }
+    }
+  }
+};
+
+// Both operations anchor the result at the lower of the two bases; members beyond MAX_BITS from it are dropped
+seq_num_set seq_num_set_union(const seq_num_set& a, const seq_num_set& b);
+seq_num_set seq_num_set_intersection(const seq_num_set& a, const seq_num_set& b);
+
+std::ostream& operator<<(std::ostream& os, const seq_num_set& sns);
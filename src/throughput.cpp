@@ -0,0 +1,187 @@
+#include "throughput.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <unordered_map>
+
+namespace {
+
+struct series_summary {
+  double samples_per_sec;
+  double bytes_per_sec;
+  size_t peak_samples_bin;
+  uint32_t peak_samples;
+  size_t peak_bytes_bin;
+  uint64_t peak_bytes;
+  double burstiness;
+  double peak_to_mean;
+};
+
+// Bins missing from a series hold no samples and no bytes, but still count towards the mean and the variance
+series_summary summarize_series(const throughput_series& s, const throughput_info& ti) {
+  series_summary result{0.0, 0.0, 0, 0, 0, 0, 0.0, 0.0};
+  size_t n = ti.bin_count;
+  if (n == 0 || s.bins.empty()) {
+    return result;
+  }
+  double duration = static_cast<double>(n) * ti.bin_width;
+  result.samples_per_sec = static_cast<double>(s.total_samples) / duration;
+  result.bytes_per_sec = static_cast<double>(s.total_bytes) / duration;
+
+  double mean = static_cast<double>(s.total_bytes) / static_cast<double>(n);
+  double sum_sq = static_cast<double>(n - s.bins.size()) * mean * mean;
+  result.peak_samples_bin = result.peak_bytes_bin = s.bins.front().bin;
+  for (const auto & b : s.bins) {
+    double d = static_cast<double>(b.bytes) - mean;
+    sum_sq += d * d;
+    if (b.samples > result.peak_samples) {
+      result.peak_samples = b.samples;
+      result.peak_samples_bin = b.bin;
+    }
+    if (b.bytes > result.peak_bytes) {
+      result.peak_bytes = b.bytes;
+      result.peak_bytes_bin = b.bin;
+    }
+  }
+  if (mean > 0.0) {
+    result.burstiness = std::sqrt(sum_sq / static_cast<double>(n)) / mean;
+    result.peak_to_mean = static_cast<double>(result.peak_bytes) / mean;
+  }
+  return result;
+}
+
+// Frames are nearly always in time order, so a sample lands in the series' last bin or opens a new one after it
+throughput_bin& current_bin(throughput_series& s, size_t bin) {
+  if (s.bins.empty() || s.bins.back().bin != bin) {
+    s.bins.push_back(throughput_bin{bin, 0, 0});
+  }
+  return s.bins.back();
+}
+
+// Sorts bins left out of order by timestamps that went backwards and merges the duplicates that leaves
+void reduce_bins(throughput_series& s) {
+  if (!std::is_sorted(s.bins.begin(), s.bins.end(), [](const throughput_bin& a, const throughput_bin& b) { return a.bin < b.bin; })) {
+    std::stable_sort(s.bins.begin(), s.bins.end(), [](const throughput_bin& a, const throughput_bin& b) { return a.bin < b.bin; });
+  }
+  size_t out = 0;
+  for (size_t i = 1; i < s.bins.size(); ++i) {
+    if (s.bins[i].bin == s.bins[out].bin) {
+      s.bins[out].samples += s.bins[i].samples;
+      s.bins[out].bytes += s.bins[i].bytes;
+    } else {
+      s.bins[++out] = s.bins[i];
+    }
+  }
+  if (!s.bins.empty()) {
+    s.bins.resize(out + 1);
+  }
+}
+
+}
+
+bool gather_throughput_info(const rtps_frame_map& frames, const endpoint_map& em, uint16_t domain, double bin_width, throughput_info& ti) {
+  ti.bin_width = bin_width;
+  ti.start_time = frames.empty() ? 0.0 : frames.begin()->second.frame_reference_time;
+  ti.bin_count = 0;
+  ti.series.clear();
+  bool binned = bin_width > 0.0;
+  if (!binned) {
+    std::cout << "Throughput bin width must be positive (got " << bin_width << ")" << std::endl;
+  }
+
+  // Writers are keyed by a participant number, found once per frame, and their parsed entity id, so that the per-sample
+  // work is integer only
+  std::unordered_map<std::string, uint64_t> participant_ids;
+  std::unordered_map<uint64_t, size_t> index;
+  std::vector<bool> excluded;
+  for (const auto & frame : frames) {
+    const rtps_frame& f = frame.second;
+    if (f.data_vec.empty()) {
+      continue;
+    }
+    size_t bin = 0;
+    if (binned) {
+      double position = std::max(0.0, (f.frame_reference_time - ti.start_time) / bin_width);
+      if (position >= static_cast<double>(MAX_THROUGHPUT_BINS)) {
+        std::cout << "Throughput bin width " << bin_width << "s gives more than " << MAX_THROUGHPUT_BINS << " bins (frame " << f.frame_no
+                  << " at " << f.frame_reference_time << "s), only totals are kept" << std::endl;
+        binned = false;
+        ti.bin_count = 0;
+        for (auto & s : ti.series) {
+          s.bins.clear();
+        }
+      } else {
+        bin = static_cast<size_t>(position);
+        ti.bin_count = std::max(ti.bin_count, bin + 1);
+      }
+    }
+    uint64_t participant = participant_ids.emplace(f.guid_prefix, participant_ids.size()).first->second;
+    for (const auto & data : f.data_vec) {
+      uint64_t key = (participant << 32) | static_cast<uint64_t>(std::strtoul(data.writer_id.c_str(), nullptr, 16));
+      auto iit = index.find(key);
+      if (iit == index.end()) {
+        iit = index.emplace(key, ti.series.size()).first;
+        std::string guid = f.guid_prefix + data.writer_id;
+        ti.series.emplace_back();
+        ti.series.back().guid = guid;
+        auto eit = em.find(guid);
+        ti.series.back().domain_id = eit == em.end() ? 0xFF : eit->second.domain_id;
+        excluded.push_back(domain != 0xFF && domain != ti.series.back().domain_id);
+      }
+      if (excluded[iit->second]) {
+        continue;
+      }
+      throughput_series& s = ti.series[iit->second];
+      ++s.total_samples;
+      throughput_bin* b = binned ? &current_bin(s, bin) : nullptr;
+      if (b != nullptr) {
+        ++b->samples;
+      }
+      // Frames carrying several DATA submessages from the same writer only count their bytes once
+      if (s.last_frame != f.frame_no) {
+        if (b != nullptr) {
+          b->bytes += f.udp_length;
+        }
+        s.total_bytes += f.udp_length;
+        s.last_frame = f.frame_no;
+      }
+    }
+  }
+
+  for (auto & s : ti.series) {
+    reduce_bins(s);
+  }
+  ti.series.erase(std::remove_if(ti.series.begin(), ti.series.end(), [](const throughput_series& s) { return s.total_samples == 0; }), ti.series.end());
+  std::sort(ti.series.begin(), ti.series.end(), [](const throughput_series& a, const throughput_series& b) { return a.total_bytes > b.total_bytes; });
+  return binned;
+}
+
+void print_throughput_stats(std::ostream& os, const throughput_info& ti) {
+  os << "Throughput Stats (bin width " << std::fixed << std::setprecision(3) << ti.bin_width << "s, " << ti.bin_count << " bins):" << std::endl;
+  for (const auto & s : ti.series) {
+    series_summary sum = summarize_series(s, ti);
+    os << " - " << s.guid << " :: samples = " << s.total_samples << ", bytes = " << s.total_bytes
+       << std::setprecision(3) << ", samples/s = " << sum.samples_per_sec << ", bytes/s = " << sum.bytes_per_sec
+       << ", peak samples/s = " << static_cast<double>(sum.peak_samples) / ti.bin_width
+       << " @ " << ti.start_time + static_cast<double>(sum.peak_samples_bin) * ti.bin_width
+       << ", peak bytes/s = " << static_cast<double>(sum.peak_bytes) / ti.bin_width
+       << " @ " << ti.start_time + static_cast<double>(sum.peak_bytes_bin) * ti.bin_width
+       << ", burstiness (cv) = " << sum.burstiness << ", peak/mean = " << sum.peak_to_mean << '\n';
+  }
+  os << std::flush;
+}
+
+void write_throughput_csv(std::ostream& os, const throughput_info& ti) {
+  os << "bin_start,guid,samples,bytes,samples_per_sec,bytes_per_sec\n";
+  os << std::fixed << std::setprecision(6);
+  for (const auto & s : ti.series) {
+    for (const auto & b : s.bins) {
+      os << ti.start_time + static_cast<double>(b.bin) * ti.bin_width << ',' << s.guid << ',' << b.samples << ',' << b.bytes << ','
+         << static_cast<double>(b.samples) / ti.bin_width << ',' << static_cast<double>(b.bytes) / ti.bin_width << '\n';
+    }
+  }
+  os << std::flush;
+}
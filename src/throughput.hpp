@@ -0,0 +1,40 @@
+#pragma once
+
+#include "endpoint_info.hpp"
+#include "frames.hpp"
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Bins with more than this many bins' worth of capture before them are refused (a tiny bin width or an outlier timestamp)
+const size_t MAX_THROUGHPUT_BINS = 10000000;
+
+struct throughput_bin {
+  size_t bin;
+  uint32_t samples;
+  uint64_t bytes;
+};
+
+struct throughput_series {
+  std::string guid;
+  size_t domain_id{0xFF};
+  size_t total_samples{0};
+  size_t total_bytes{0};
+  size_t last_frame{0};
+  std::vector<throughput_bin> bins; // only bins the writer sent samples in, in increasing order
+};
+
+struct throughput_info {
+  double bin_width{1.0};
+  double start_time{0.0};
+  size_t bin_count{0};
+  std::vector<throughput_series> series;
+};
+
+// Buckets every DATA submessage by writer GUID into fixed-width bins of frame_reference_time in a single pass over the frames.
+// Returns false, leaving only the per-writer totals, if bin_width isn't positive or the capture spans more than MAX_THROUGHPUT_BINS bins.
+bool gather_throughput_info(const rtps_frame_map& frames, const endpoint_map& em, uint16_t domain, double bin_width, throughput_info& ti);
+void print_throughput_stats(std::ostream& os, const throughput_info& ti);
+// Writes one row per writer and non-empty bin
+void write_throughput_csv(std::ostream& os, const throughput_info& ti);
@@ -0,0 +1,113 @@
+#include "topics.hpp"
+
+#include <iomanip>
+
+namespace {
+
+bool is_writer_guid(const std::string& guid) {
+  char kind = guid.back();
+  return kind == '2' || kind == '3';
+}
+
+}
+
+void gather_topic_index(endpoint_map& em, topic_index& ti) {
+  for (auto & it : em) {
+    endpoint_info& info = it.second;
+    const rtps_data* latest = nullptr;
+    for (const auto & d : info.sedp_announcements) {
+      // Reader announcements also list the writers registered with them; those entries announce someone else
+      if (d.second->endpoint_guid == info.guid && !d.second->topic_name.empty()) {
+        latest = d.second;
+      }
+    }
+    if (latest == nullptr) {
+      continue;
+    }
+    auto iit = ti.ids.find(latest->topic_name);
+    if (iit == ti.ids.end()) {
+      iit = ti.ids.emplace(latest->topic_name, static_cast<uint32_t>(ti.topics.size())).first;
+      ti.topics.emplace_back();
+      ti.topics.back().name = latest->topic_name;
+      ti.topics.back().type_name = latest->type_name;
+    }
+    info.topic_id = iit->second;
+    info.type_id = ti.type_ids.emplace(latest->type_name, static_cast<uint32_t>(ti.type_names.size())).first->second;
+    if (info.type_id == ti.type_names.size()) {
+      ti.type_names.push_back(latest->type_name);
+    }
+    topic_info& topic = ti.topics[info.topic_id];
+    (is_writer_guid(info.guid) ? topic.writers : topic.readers).push_back(&info);
+  }
+}
+
+const topic_info* find_topic(const topic_index& ti, const endpoint_map& em, const std::string& guid) {
+  auto it = em.find(guid);
+  if (it == em.end() || it->second.topic_id == NO_TOPIC) {
+    return nullptr;
+  }
+  return &ti.topics[it->second.topic_id];
+}
+
+void gather_topic_conversations(const topic_index& ti, const endpoint_map& em, const conversation_map& cm, uint16_t domain, std::vector<std::vector<const conversation_info*>>& conversations) {
+  conversations.clear();
+  conversations.resize(ti.topics.size() + 1);
+  for (const auto & it : cm) {
+    auto wit = em.find(it.first);
+    size_t topic_id = (wit == em.end() || wit->second.topic_id == NO_TOPIC) ? ti.topics.size() : wit->second.topic_id;
+    for (const auto & it2 : it.second) {
+      if (domain == 0xFF || domain == it2.second.domain_id) {
+        conversations[topic_id].push_back(&it2.second);
+      }
+    }
+  }
+}
+
+void gather_topic_stats(const topic_index& ti, const endpoint_map& em, const conversation_map& cm, const throughput_info& tpi, uint16_t domain, std::vector<topic_stats>& stats) {
+  stats.clear();
+  stats.resize(ti.topics.size());
+  for (size_t i = 0; i < ti.topics.size(); ++i) {
+    for (const endpoint_info* w : ti.topics[i].writers) {
+      stats[i].writer_count += (domain == 0xFF || domain == w->domain_id) ? 1 : 0;
+    }
+    for (const endpoint_info* r : ti.topics[i].readers) {
+      stats[i].reader_count += (domain == 0xFF || domain == r->domain_id) ? 1 : 0;
+    }
+  }
+
+  std::vector<std::vector<const conversation_info*>> conversations;
+  gather_topic_conversations(ti, em, cm, domain, conversations);
+  for (size_t i = 0; i < ti.topics.size(); ++i) {
+    for (const conversation_info* conv : conversations[i]) {
+      auto wit = em.find(conv->writer_guid);
+      auto rit = em.find(conv->reader_guid);
+      if (rit == em.end()) {
+        continue;
+      }
+      ++stats[i].conversation_count;
+      stats[i].discovery_time.record(conv->first_evidence_time - std::max(wit->second.first_evidence_time, rit->second.first_evidence_time));
+    }
+  }
+
+  for (const auto & s : tpi.series) {
+    auto wit = em.find(s.guid);
+    if (wit != em.end() && wit->second.topic_id != NO_TOPIC) {
+      stats[wit->second.topic_id].samples += s.total_samples;
+      stats[wit->second.topic_id].bytes += s.total_bytes;
+    }
+  }
+}
+
+void print_topic_stats(std::ostream& os, const topic_index& ti, const std::vector<topic_stats>& stats) {
+  os << "Topic Stats:" << std::endl;
+  for (size_t i = 0; i < ti.topics.size(); ++i) {
+    const topic_stats& ts = stats[i];
+    os << " - " << ti.topics[i].name << " (" << ti.topics[i].type_name << ") :: writers = " << ts.writer_count << ", readers = " << ts.reader_count
+       << ", conversations = " << ts.conversation_count << std::fixed << std::setprecision(6);
+    if (ts.discovery_time.count() != 0u) {
+      os << ", discovery p50 = " << ts.discovery_time.percentile(50.0) << ", p99 = " << ts.discovery_time.percentile(99.0) << ", max = " << ts.discovery_time.max();
+    }
+    os << ", samples = " << ts.samples << ", bytes = " << ts.bytes << '\n';
+  }
+  os << std::flush;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "conversation_info.hpp"
+#include "endpoint_info.hpp"
+#include "hdr_histogram.hpp"
+#include "throughput.hpp"
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct topic_info {
+  std::string name;
+  std::string type_name;
+  std::vector<const endpoint_info*> writers;
+  std::vector<const endpoint_info*> readers;
+};
+
+// Topic and type names are interned once each: endpoints refer to them by endpoint_info::topic_id and type_id. A topic's
+// type_name is the first one announced for it; endpoints announcing another type keep their own type_id.
+struct topic_index {
+  std::vector<topic_info> topics;
+  std::unordered_map<std::string, uint32_t> ids;
+  std::vector<std::string> type_names;
+  std::unordered_map<std::string, uint32_t> type_ids;
+};
+
+struct topic_stats {
+  size_t writer_count{0};
+  size_t reader_count{0};
+  size_t conversation_count{0};
+  hdr_histogram discovery_time;
+  size_t samples{0};
+  size_t bytes{0};
+};
+
+// Assigns each endpoint the topic named by its own latest SEDP announcement and files it under that topic
+void gather_topic_index(endpoint_map& em, topic_index& ti);
+
+// Topic of the endpoint with the given guid, or nullptr if it isn't known
+const topic_info* find_topic(const topic_index& ti, const endpoint_map& em, const std::string& guid);
+
+// Conversations filed under their writer's topic (indexed like ti.topics, with one extra last entry for conversations
+// whose writer has no topic, such as builtin ones), each in conversation_map order
+void gather_topic_conversations(const topic_index& ti, const endpoint_map& em, const conversation_map& cm, uint16_t domain, std::vector<std::vector<const conversation_info*>>& conversations);
+
+// Groups endpoint counts, conversation discovery times and writer throughput by topic (stats is indexed like ti.topics)
+void gather_topic_stats(const topic_index& ti, const endpoint_map& em, const conversation_map& cm, const throughput_info& tpi, uint16_t domain, std::vector<topic_stats>& stats);
+void print_topic_stats(std::ostream& os, const topic_index& ti, const std::vector<topic_stats>& stats);
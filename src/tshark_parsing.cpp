@@ -1,10 +1,15 @@
 #include "tshark_parsing.hpp"
 
+#include "field_table.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <ios>
 #include <iostream>
 #include <sstream>
 
-bool process_frame_header(const string_vec& frame_header, rtps_frame& frame) {
+bool process_frame_header(const line_range& frame_header, rtps_frame& frame) {
   bool result = false;
   size_t frame_no = 0;
   double frame_epoch_time = -1.0;
@@ -36,7 +41,7 @@ bool process_frame_header(const string_vec& frame_header, rtps_frame& frame) {
   return result;
 }
 
-bool process_eth_header(const string_vec& eth_header, rtps_frame& frame) {
+bool process_eth_header(const line_range& eth_header, rtps_frame& frame) {
   bool result = false;
   std::string src_mac;
   std::string dst_mac;
@@ -80,16 +85,19 @@ bool process_eth_header(const string_vec& eth_header, rtps_frame& frame) {
   return result;
 }
 
-bool process_ip_header(const string_vec& ip_header, rtps_frame& frame, ip_frag_map& ifm) {
+bool process_ip_header(const line_range& ip_header, rtps_frame& frame, ip_fragment_tracker& ift) {
   bool result = false;
-  bool ip_fragmentation = false;
+  bool more_fragments = false;
   std::string src_ip;
   std::string dst_ip;
-  std::string id;
+  uint16_t id = 0;
+  unsigned protocol = 0;
   size_t frag_off = 0;
+  size_t total_length = 0;
+  size_t header_length = 0;
 
   for (const auto & it : ip_header) {
-    size_t spos, dpos, fpos, ipos;
+    size_t spos, dpos, fpos, ipos, lpos, ppos;
     if ((spos = it.find("Source: ")) != std::string::npos) {
       src_ip = it.substr(spos + 8);
       //std::cout << src_ip << std::endl;
@@ -97,42 +105,39 @@ bool process_ip_header(const string_vec& ip_header, rtps_frame& frame, ip_frag_m
       dst_ip = it.substr(dpos + 13);
       //std::cout << dst_ip << std::endl;
     } else if (it.find("More fragments: Set") != std::string::npos) {
-      ip_fragmentation = true;
-    } else if ((fpos = it.find("Fragment offset: ")) != std::string::npos) {
-      std::string full = it.substr(fpos + 17);
-      std::stringstream ss(full);
+      more_fragments = true;
+    } else if ((fpos = it.find("Fragment offset: ")) != std::string::npos || (fpos = it.find("Fragment Offset: ")) != std::string::npos) {
+      std::stringstream ss(it.substr(fpos + 17));
       ss >> frag_off;
     } else if ((ipos = it.find("Identification: ")) != std::string::npos) {
-      id = it.substr(ipos + 16);
+      std::stringstream ss(it.substr(ipos + 16));
+      ss >> std::hex >> id;
+    } else if ((lpos = it.find("Total Length: ")) != std::string::npos) {
+      std::stringstream ss(it.substr(lpos + 14));
+      ss >> total_length;
+    } else if ((lpos = it.find("Header Length: ")) != std::string::npos) {
+      std::stringstream ss(it.substr(lpos + 15));
+      ss >> header_length;
+    } else if ((ppos = it.find("Protocol: ")) != std::string::npos && (ppos = it.find('(', ppos)) != std::string::npos) {
+      std::stringstream ss(it.substr(ppos + 1));
+      ss >> protocol;
     }
   }
 
-  std::string full_id = id + "," + src_ip + "," + dst_ip;
-
-  if (ip_fragmentation) {
-    auto iter = ifm.find(id);
-    if (iter == ifm.end()) {
-      ifm[full_id].first = std::make_pair(frame.frame_no, frame.frame_reference_time);
-      ifm[full_id].second = 0;
-    }
-  } else if (!src_ip.empty() && !dst_ip.empty()) {
-    if (frag_off != 0) {
-      auto iter = ifm.find(full_id);
-      if (iter != ifm.end()) {
-        if (iter->second.second != 0) {
-          std::cout << "ip fragmentation id / src / dst collision!" << std::endl;
-        }
-        iter->second.second = frame.frame_no;
-      }
-    }
+  if (!src_ip.empty() && !dst_ip.empty()) {
     frame.src_ip = src_ip;
     frame.dst_ip = dst_ip;
+    if (more_fragments || frag_off != 0) {
+      ip_fragment frag{src_ip, dst_ip, id, static_cast<uint8_t>(protocol), frag_off, total_length - std::min(header_length, total_length), more_fragments};
+      track_ip_fragment(frag, frame, ift);
+    }
+    // Fragments that don't complete a datagram carry no UDP header, so they drop out at the next stage
     result = true;
   }
   return result;
 }
 
-bool process_udp_header(const string_vec& udp_header, rtps_frame& frame) {
+bool process_udp_header(const line_range& udp_header, rtps_frame& frame) {
   bool result = false;
   std::string src_port;
   std::string dst_port;
@@ -162,7 +167,7 @@ bool process_udp_header(const string_vec& udp_header, rtps_frame& frame) {
   return result;
 }
 
-bool process_rtps_header(const string_vec& rtps_header, rtps_frame& frame) {
+bool process_rtps_header(const line_range& rtps_header, rtps_frame& frame) {
   bool result = false;
   uint16_t domain_id = 0xFFFF;
   std::string guid_prefix;
@@ -187,526 +192,506 @@ bool process_rtps_header(const string_vec& rtps_header, rtps_frame& frame) {
   return result;
 }
 
-bool process_rtps_info_dst_submessage(const string_vec& rtps_submessage, rtps_frame& frame, size_t sm_order) {
-  bool result = false;
-  uint16_t flags = 0xFFFF;
-  std::string guid_prefix;
+bool process_rtps_info_dst_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order) {
+  size_t flags_node = tree.find_child(sm_node, "Flags");
+  size_t prefix_node = tree.find_child(sm_node, "guidPrefix");
+  if (flags_node == std::string::npos || prefix_node == std::string::npos) {
+    return false;
+  }
+  rtps_info_dst info_dst;
+  info_dst.flags = static_cast<uint16_t>(std::strtoul(tree.value(flags_node), nullptr, 16));
+  info_dst.guid_prefix = tree.value(prefix_node);
+  info_dst.sm_order = sm_order;
+  frame.info_dst_vec.push_back(info_dst);
+  return true;
+}
 
-  //std::cout << "info_dst submessage:" << std::endl;
-  if (rtps_submessage.size() > 1) {
-    size_t fpos;
-    if ((fpos = rtps_submessage[1].find("Flags: ")) != std::string::npos) {
-      std::stringstream ss(rtps_submessage[1].substr(fpos + 7));
-      ss >> std::hex >> flags;
-      //std::cout << " - flags = " << flags << std::endl;
-    }
+namespace {
+
+bool parse_entity_id(const field_cursor& c, std::string& out) {
+  // Either "0x000100c2 (...)" or "ENTITYID_... (0x000100c2)"
+  const std::string& line = c.line();
+  size_t pos = c.value_pos;
+  if (line.compare(pos, 2, "0x") == 0) {
+    out = line.substr(pos + 2, 8);
+  } else if ((pos = line.find("(0x", pos)) != std::string::npos) {
+    out = line.substr(pos + 3, 8);
   }
+  return true;
+}
 
-  for (const auto & it : rtps_submessage) {
-    size_t gpos;
-    if ((gpos = it.find("guidPrefix: ")) != std::string::npos) {
-      guid_prefix = it.substr(gpos + 12);
-      //std::cout << " - guid_prefix = " << guid_prefix << std::endl;
-    }
+bool parse_size(const field_cursor& c, size_t& out) {
+  out = static_cast<size_t>(std::strtoull(c.value(), nullptr, 10));
+  return true;
+}
+
+bool parse_set(const field_cursor&, bool& out) {
+  out = true;
+  return true;
+}
+
+bool parse_guid(const char* value, std::string& out) {
+  // Printed as four space separated quarters
+  std::stringstream ss(value);
+  for (int i = 0; i < 4; ++i) {
+    std::string quarter;
+    ss >> quarter;
+    out += quarter;
   }
+  return true;
+}
 
-  if (flags != 0xFFFF && !guid_prefix.empty()) {
-    rtps_info_dst info_dst;
-    info_dst.flags = flags;
-    info_dst.guid_prefix = guid_prefix;
-    info_dst.sm_order = sm_order;
-    frame.info_dst_vec.push_back(info_dst);
-    result = true;
+bool parse_participant_guid(const field_cursor& c, std::string& out) {
+  const char* value = c.child_value("Participant GUID");
+  return value == nullptr || parse_guid(value, out);
+}
+
+bool parse_endpoint_guid(const field_cursor& c, std::string& out) {
+  const char* value = c.child_value("Endpoint GUID");
+  return value == nullptr || parse_guid(value, out);
+}
+
+bool parse_status_info(const field_cursor& c, bool& unregistered, bool& disposed) {
+  unregistered |= c.tree.find_in_subtree(c.node, " = Unregistered: Set") != std::string::npos;
+  disposed |= c.tree.find_in_subtree(c.node, " = Disposed: Set") != std::string::npos;
+  return true;
+}
+
+bool parse_locator(const field_cursor& c, string_vec& ips, string_vec& ports) {
+  // "kind, ip:port)"
+  std::stringstream ss(c.value());
+  std::string kind_comma, ip_port_paren;
+  ss >> kind_comma >> ip_port_paren;
+  auto cpos = ip_port_paren.find(':');
+  ips.emplace_back(ip_port_paren.substr(0, cpos));
+  ports.emplace_back(ip_port_paren.substr(cpos + 1, ip_port_paren.find(')') - (cpos + 1)));
+  return true;
+}
+
+bool parse_registered_writer(const field_cursor& c, string_vec& out) {
+  const char* value = c.child_value("parameterData");
+  if (value != nullptr) {
+    out.emplace_back(value);
   }
-  return result;
+  return true;
 }
 
-bool process_rtps_data_submessage(const string_vec& rtps_submessage, rtps_frame& frame, size_t sm_order) {
-  bool result = false;
-  uint16_t flags = 0xFFFF;
-  std::string reader_id;
-  std::string writer_id;
-  size_t writer_seq_num = 0;
-  std::string participant_guid;
-  string_vec metatraffic_unicast_locator_ips;
-  string_vec metatraffic_unicast_locator_ports;
-  string_vec metatraffic_multicast_locator_ips;
-  string_vec metatraffic_multicast_locator_ports;
-  std::string endpoint_guid;
-  string_vec unicast_locator_ips;
-  string_vec unicast_locator_ports;
-  string_vec multicast_locator_ips;
-  string_vec multicast_locator_ports;
-  string_vec registered_writers;
-  bool endpoint_reliability = false;
-  bool unregistered = false;
-  bool disposed = false;
-  uint32_t builtins = 0;
-  uint32_t domain_id = 0;
-
-  //std::cout << "data submessage:" << std::endl;
-  if (rtps_submessage.size() > 1) {
-    size_t fpos;
-    if ((fpos = rtps_submessage[1].find("Flags: ")) != std::string::npos) {
-      std::stringstream ss(rtps_submessage[1].substr(fpos + 7));
-      ss >> std::hex >> flags;
-      //std::cout << " - flags = " << flags << std::endl;
-    }
+bool parse_reliability(const field_cursor& c, bool& out) {
+  const char* value = c.child_value("Kind");
+  if (value != nullptr) {
+    out = std::strcmp(value, "RELIABLE_RELIABILITY_QOS (0x00000002)") == 0;
   }
+  return true;
+}
 
-  for (auto it = rtps_submessage.begin(); it != rtps_submessage.end(); ++it) {
-    size_t rpos, wpos, spos, pgpos, egpos, mulpos, ulpos, rwpos, bpos;
-    if ((rpos = it->find("readerEntityId: 0x")) != std::string::npos) {
-      reader_id = it->substr(rpos + 18, 8);
-      //std::cout << " - reader_id = " << reader_id << std::endl;
-    } else if ((rpos = it->find("readerEntityId: ")) != std::string::npos) {
-      std::string full = it->substr(rpos + 16);
-      if ((rpos = full.find("(0x")) != std::string::npos) {
-        reader_id = full.substr(rpos + 3, 8);
-        //std::cout << " - reader_id = " << reader_id << std::endl;
-      }
-    } else if ((wpos = it->find("writerEntityId: 0x")) != std::string::npos) {
-      writer_id = it->substr(wpos + 18, 8);
-      //std::cout << " - writer_id = " << writer_id << std::endl;
-    } else if ((wpos = it->find("writerEntityId: ")) != std::string::npos) {
-      std::string full = it->substr(wpos + 16);
-      if ((wpos = full.find("(0x")) != std::string::npos) {
-        writer_id = full.substr(wpos + 3, 8);
-        //std::cout << " - writer_id = " << writer_id << std::endl;
-      }
-    } else if (it->find(" = Unregistered: Set") != std::string::npos) {
-      unregistered = true;
-      //std::cout << " - unregistered = " << unregistered << std::endl;
-    } else if (it->find(" = Disposed: Set") != std::string::npos) {
-      disposed = true;
-      //std::cout << " - disposed = " << disposed << std::endl;
-    } else if ((spos = it->find("writerSeqNumber: ")) != std::string::npos) {
-      std::string full = it->substr(spos + 17);
-      std::stringstream ss(full);
-      ss >> writer_seq_num;
-      //std::cout << " - writer_seq_num = " << writer_seq_num << std::endl;
-    } else if ((pgpos = it->find("Participant GUID: ")) != std::string::npos) {
-      std::string full = it->substr(pgpos + 18);
-      std::stringstream ss(full);
-      for (int i = 0; i < 4; ++i) {
-        std::string quarter;
-        ss >> quarter;
-        participant_guid += quarter;
-      }
-      //std::cout << " - participant_guid = " << participant_guid << std::endl;
-    } else if ((egpos = it->find("Endpoint GUID: ")) != std::string::npos) {
-      std::string full = it->substr(egpos + 15);
-      std::stringstream ss(full);
-      for (int i = 0; i < 4; ++i) {
-        std::string quarter;
-        ss >> quarter;
-        endpoint_guid += quarter;
-      }
-      //std::cout << " - endpoint_guid = " << endpoint_guid << std::endl;
-    } else if ((mulpos = it->find("  PID_METATRAFFIC_UNICAST_LOCATOR (")) != std::string::npos) {
-      std::string full = it->substr(mulpos + 35);
-      std::stringstream ss(full);
-      std::string kind_comma, ip_port_paren;
-      ss >> kind_comma >> ip_port_paren;
-      auto cpos = ip_port_paren.find(':');
-      metatraffic_unicast_locator_ips.emplace_back(ip_port_paren.substr(0, cpos));
-      metatraffic_unicast_locator_ports.emplace_back(ip_port_paren.substr(cpos + 1, ip_port_paren.find(')') - (cpos + 1)));
-      //std::cout << " - metatraffic_unicast_locator_ip = " << metatraffic_unicast_locator_ips.back() << std::endl;
-      //std::cout << " - metatraffic_unicast_locator_port = " << metatraffic_unicast_locator_ports.back() << std::endl;
-    } else if ((mulpos = it->find("  PID_METATRAFFIC_MULTICAST_LOCATOR (")) != std::string::npos) {
-      std::string full = it->substr(mulpos + 37);
-      std::stringstream ss(full);
-      std::string kind_comma, ip_port_paren;
-      ss >> kind_comma >> ip_port_paren;
-      auto cpos = ip_port_paren.find(':');
-      metatraffic_multicast_locator_ips.emplace_back(ip_port_paren.substr(0, cpos));
-      metatraffic_multicast_locator_ports.emplace_back(ip_port_paren.substr(cpos + 1, ip_port_paren.find(')') - (cpos + 1)));
-      //std::cout << " - metatraffic_multicast_locator_ip = " << metatraffic_multicast_locator_ips.back() << std::endl;
-      //std::cout << " - metatraffic_multicast_locator_port = " << metatraffic_multicast_locator_ports.back() << std::endl;
-    } else if ((mulpos = it->find("  PID_UNICAST_LOCATOR (")) != std::string::npos) {
-      std::string full = it->substr(mulpos + 23);
-      std::stringstream ss(full);
-      std::string kind_comma, ip_port_paren;
-      ss >> kind_comma >> ip_port_paren;
-      auto cpos = ip_port_paren.find(':');
-      unicast_locator_ips.emplace_back(ip_port_paren.substr(0, cpos));
-      unicast_locator_ports.emplace_back(ip_port_paren.substr(cpos + 1, ip_port_paren.find(')') - (cpos + 1)));
-      //std::cout << " - unicast_locator_ip = " << unicast_locator_ips.back() << std::endl;
-      //std::cout << " - unicast_locator_port = " << unicast_locator_ports.back() << std::endl;
-    } else if ((mulpos = it->find("  PID_MULTICAST_LOCATOR (")) != std::string::npos) {
-      std::string full = it->substr(mulpos + 25);
-      std::stringstream ss(full);
-      std::string kind_comma, ip_port_paren;
-      ss >> kind_comma >> ip_port_paren;
-      auto cpos = ip_port_paren.find(':');
-      multicast_locator_ips.emplace_back(ip_port_paren.substr(0, cpos));
-      multicast_locator_ports.emplace_back(ip_port_paren.substr(cpos + 1, ip_port_paren.find(')') - (cpos + 1)));
-      //std::cout << " - multicast_locator_ip = " << multicast_locator_ips.back() << std::endl;
-      //std::cout << " - multicast_locator_port = " << multicast_locator_ports.back() << std::endl;
-    } else if ((rwpos = it->find("  Unknown (0xb002)")) != std::string::npos) {
-      auto it2 = it; ++it2; ++it2; ++it2;
-      if ((rwpos = it2->find("parameterData: ")) != std::string::npos) {
-        std::string guid = it2->substr(rwpos + 15);
-        registered_writers.push_back(guid);
-        //std::cout << " - registered writer " << guid << std::endl;
-      }
-    } else if ((rpos = it->find("  PID_RELIABILITY")) != std::string::npos) {
-      auto it2 = it; ++it2; ++it2; ++it2;
-      if ((rpos = it2->find("Kind: ")) != std::string::npos) {
-        std::string kind = it2->substr(rpos + 6);
-        endpoint_reliability = (kind == "RELIABLE_RELIABILITY_QOS (0x00000002)");
-        //std::cout << " - endpoint_reliability " << endpoint_reliability << std::endl;
-      }
-    } else if ((bpos = it->find("  PID_BUILTIN_ENDPOINT_SET")) != std::string::npos) {
-      auto it2 = it; ++it2; ++it2; ++it2;
-      if ((bpos = it2->find("Flags: ")) != std::string::npos) {
-        std::stringstream ss(it2->substr(bpos + 7));
-        ss >> std::hex >> builtins;
-      }
-      //std::cout << " - builtin endpoint flags " << std::hex << builtins << std::endl;
-    } else if ((bpos = it->find("  PID_RTI_DOMAIN_ID")) != std::string::npos) {
-      auto it2 = it; ++it2; ++it2; ++it2;
-      if ((bpos = it2->find("domain_id: ")) != std::string::npos) {
-        std::stringstream ss(it2->substr(bpos + 11));
-        ss >> domain_id;
-      }
-      //std::cout << " - domain id " << domain_id << std::endl;
-    }
+bool parse_topic_name(const field_cursor& c, std::string& out) {
+  const char* value = c.child_value("topic");
+  if (value != nullptr) {
+    out = value;
   }
+  return true;
+}
 
-  if (flags != 0xFFFF && !reader_id.empty() && !writer_id.empty()) {
-    rtps_data data;
-    data.flags = flags;
-    data.reader_id = reader_id;
-    data.writer_id = writer_id;
-    data.writer_seq_num = writer_seq_num;
-    data.unregistered = unregistered;
-    data.disposed = disposed;
-    if (participant_guid.length() == 32) {
-      data.participant_guid = participant_guid;
-      data.metatraffic_unicast_locator_ips = metatraffic_unicast_locator_ips;
-      data.metatraffic_unicast_locator_ports = metatraffic_unicast_locator_ports;
-      data.metatraffic_multicast_locator_ips = metatraffic_multicast_locator_ips;
-      data.metatraffic_multicast_locator_ports = metatraffic_multicast_locator_ports;
-      data.builtins = builtins;
-    }
-    if (endpoint_guid.length() == 32) {
-      data.endpoint_guid = endpoint_guid;
-      data.unicast_locator_ips = unicast_locator_ips;
-      data.unicast_locator_ports = unicast_locator_ports;
-      data.multicast_locator_ips = multicast_locator_ips;
-      data.multicast_locator_ports = multicast_locator_ports;
-      data.registered_writers = registered_writers;
-      data.endpoint_reliability = endpoint_reliability;
-    }
-    data.sm_order = sm_order;
-    frame.data_vec.push_back(data);
-    frame.domain_id = domain_id;
-    result = true;
+bool parse_type_name(const field_cursor& c, std::string& out) {
+  const char* value = c.child_value("typeName");
+  if (value != nullptr) {
+    out = value;
   }
-  return result;
+  return true;
 }
 
-bool process_rtps_gap_submessage(const string_vec& rtps_submessage, rtps_frame& frame, size_t sm_order) {
-  bool result = false;
-  uint16_t flags = 0xFFFF;
-  std::string reader_id;
-  std::string writer_id;
-  size_t gap_start = 0;
-  size_t bitmap_base = 0;
-  std::string bitmap;
-
-  //std::cout << "gap submessage:" << std::endl;
-  if (rtps_submessage.size() > 1) {
-    size_t fpos;
-    if ((fpos = rtps_submessage[1].find("Flags: ")) != std::string::npos) {
-      std::stringstream ss(rtps_submessage[1].substr(fpos + 7));
-      ss >> std::hex >> flags;
-      //std::cout << " - flags = " << flags << std::endl;
-    }
+// QoS kinds are printed as "NAME_QOS (0x0000000n)"
+uint8_t parse_qos_kind(const char* value) {
+  const char* code = std::strstr(value, "(0x");
+  return code == nullptr ? 0 : static_cast<uint8_t>(std::strtoul(code + 3, nullptr, 16));
+}
+
+bool parse_durability(const field_cursor& c, uint8_t& out) {
+  const char* value = c.child_value("Durability");
+  if (value != nullptr) {
+    out = parse_qos_kind(value);
   }
+  return true;
+}
 
-  for (const auto & it : rtps_submessage) {
-    size_t rpos, wpos, bpos;
-    if ((rpos = it.find("readerEntityId: 0x")) != std::string::npos) {
-      reader_id = it.substr(rpos + 18, 8);
-      //std::cout << " - reader_id = " << reader_id << std::endl;
-    } else if ((rpos = it.find("readerEntityId: ")) != std::string::npos) {
-      std::string full = it.substr(rpos + 16);
-      if ((rpos = full.find("(0x")) != std::string::npos) {
-        reader_id = full.substr(rpos + 3, 8);
-        //std::cout << " - reader_id = " << reader_id << std::endl;
-      }
-    } else if ((wpos = it.find("writerEntityId: 0x")) != std::string::npos) {
-      writer_id = it.substr(wpos + 18, 8);
-      //std::cout << " - writer_id = " << writer_id << std::endl;
-    } else if ((wpos = it.find("writerEntityId: ")) != std::string::npos) {
-      std::string full = it.substr(wpos + 16);
-      if ((wpos = full.find("(0x")) != std::string::npos) {
-        writer_id = full.substr(wpos + 3, 8);
-        //std::cout << " - writer_id = " << writer_id << std::endl;
-      }
-    } else if ((bpos = it.find("gapStart: ")) != std::string::npos) {
-      std::string full = it.substr(bpos + 10);
-      std::stringstream ss(full);
-      ss >> gap_start;
-    } else if ((bpos = it.find("bitmapBase: ")) != std::string::npos) {
-      std::string full = it.substr(bpos + 12);
-      std::stringstream ss(full);
-      ss >> bitmap_base;
-    } else if ((bpos = it.find("bitmap: ")) != std::string::npos) {
-      bitmap = it.substr(bpos + 8);
-    }
+bool parse_ownership(const field_cursor& c, uint8_t& out) {
+  const char* value = c.child_value("Kind");
+  if (value != nullptr) {
+    out = parse_qos_kind(value);
+  }
+  return true;
+}
+
+bool parse_deadline(const field_cursor& c, double& out) {
+  const char* value = c.child_value("period");
+  if (value != nullptr) {
+    char* end = nullptr;
+    double period = std::strtod(value, &end);
+    out = end != value ? period : -1.0; // INFINITE
   }
+  return true;
+}
 
-  if (flags != 0xFFFF && !reader_id.empty() && !writer_id.empty()) {
-    rtps_gap gap;
-    gap.flags = flags;
-    gap.reader_id = reader_id;
-    gap.writer_id = writer_id;
-    gap.gap_start = gap_start;
-    gap.bitmap_base = bitmap_base;
-    gap.bitmap = bitmap;
-    gap.sm_order = sm_order;
-    frame.gap_vec.push_back(gap);
-    result = true;
+bool parse_builtin_endpoints(const field_cursor& c, uint32_t& out) {
+  const char* value = c.child_value("Flags");
+  if (value != nullptr) {
+    out = static_cast<uint32_t>(std::strtoul(value, nullptr, 16));
   }
-  return result;
+  return true;
 }
 
-bool process_rtps_heartbeat_submessage(const string_vec& rtps_submessage, rtps_frame& frame, size_t sm_order) {
-  bool result = false;
-  uint16_t flags = 0xFFFF;
-  std::string reader_id;
-  std::string writer_id;
-  size_t first_sequence_number = 0;
-  size_t last_sequence_number = 0;
-
-  //std::cout << "heartbeat submessage:" << std::endl;
-  if (rtps_submessage.size() > 1) {
-    size_t fpos;
-    if ((fpos = rtps_submessage[1].find("Flags: ")) != std::string::npos) {
-      std::stringstream ss(rtps_submessage[1].substr(fpos + 7));
-      ss >> std::hex >> flags;
-      //std::cout << " - flags = " << flags << std::endl;
-    }
+bool parse_lease_duration(const field_cursor& c, double& out) {
+  const char* value = c.child_value("Duration");
+  if (value != nullptr) {
+    char* end = nullptr;
+    double duration = std::strtod(value, &end);
+    out = end != value ? duration : -1.0; // INFINITE
   }
+  return true;
+}
 
-  for (const auto & it : rtps_submessage) {
-    size_t rpos, wpos, spos;
-    if ((rpos = it.find("readerEntityId: 0x")) != std::string::npos) {
-      reader_id = it.substr(rpos + 18, 8);
-      //std::cout << " - reader_id = " << reader_id << std::endl;
-    } else if ((rpos = it.find("readerEntityId: ")) != std::string::npos) {
-      std::string full = it.substr(rpos + 16);
-      if ((rpos = full.find("(0x")) != std::string::npos) {
-        reader_id = full.substr(rpos + 3, 8);
-        //std::cout << " - reader_id = " << reader_id << std::endl;
-      }
-    } else if ((wpos = it.find("writerEntityId: 0x")) != std::string::npos) {
-      writer_id = it.substr(wpos + 18, 8);
-      //std::cout << " - writer_id = " << writer_id << std::endl;
-    } else if ((wpos = it.find("writerEntityId: ")) != std::string::npos) {
-      std::string full = it.substr(wpos + 16);
-      if ((wpos = full.find("(0x")) != std::string::npos) {
-        writer_id = full.substr(wpos + 3, 8);
-        //std::cout << " - writer_id = " << writer_id << std::endl;
-      }
-    } else if ((spos = it.find("firstAvailableSeqNumber: ")) != std::string::npos) {
-      std::string full = it.substr(spos + 25);
-      std::stringstream ss(full);
-      ss >> first_sequence_number;
-      //std::cout << " - first_sequence_number = " << first_sequence_number << std::endl;
-    } else if ((spos = it.find("lastSeqNumber: ")) != std::string::npos) {
-      std::string full = it.substr(spos + 15);
-      std::stringstream ss(full);
-      ss >> last_sequence_number;
-      //std::cout << " - last_sequence_number = " << last_sequence_number << std::endl;
+bool parse_key_hash(const field_cursor& c, std::string& out) {
+  // The hash is the parameter's only child after its id and length, whatever tshark labels it
+  for (size_t i = c.node + 1; i < c.tree.end(c.node); i = c.tree.end(i)) {
+    if (!c.tree.label_starts_with(i, "parameterId") && !c.tree.label_starts_with(i, "parameterLength")) {
+      std::string full = c.tree.value(i);
+      full.erase(std::remove(full.begin(), full.end(), ' '), full.end());
+      out = full.substr(0, 32);
+      break;
     }
   }
+  return true;
+}
 
-  if (flags != 0xFFFF && !reader_id.empty() && !writer_id.empty()) {
-    rtps_heartbeat heartbeat;
-    heartbeat.flags = flags;
-    heartbeat.reader_id = reader_id;
-    heartbeat.writer_id = writer_id;
-    heartbeat.first_seq_num = first_sequence_number;
-    heartbeat.last_seq_num = last_sequence_number;
-    heartbeat.sm_order = sm_order;
-    frame.heartbeat_vec.push_back(heartbeat);
-    result = true;
+bool parse_domain_id(const field_cursor& c, uint32_t& out) {
+  const char* value = c.child_value("domain_id");
+  if (value != nullptr) {
+    out = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
   }
-  return result;
+  return true;
 }
 
-bool process_rtps_acknack_submessage(const string_vec& rtps_submessage, rtps_frame& frame, size_t sm_order) {
-  bool result = false;
-  uint16_t flags = 0xFFFF;
-  std::string reader_id;
-  std::string writer_id;
-  size_t bitmap_base = 0;
-  std::string bitmap;
-
-  //std::cout << "acknack submessage:" << std::endl;
-  if (rtps_submessage.size() > 1) {
-    size_t fpos;
-    if ((fpos = rtps_submessage[1].find("Flags: ")) != std::string::npos) {
-      std::stringstream ss(rtps_submessage[1].substr(fpos + 7));
-      ss >> std::hex >> flags;
-      //std::cout << " - flags = " << flags << std::endl;
-    }
+bool parse_bitmap_base(const field_cursor& c, seq_num_set& out) {
+  out.base = static_cast<size_t>(std::strtoull(c.value(), nullptr, 10));
+  return true;
+}
+
+// A malformed bitmap only loses the odd bit, which is no reason to drop the whole frame
+bool parse_bitmap(const field_cursor& c, seq_num_set& out) {
+  out.parse(out.base, c.line().substr(c.value_pos));
+  return true;
+}
+
+// Longer labels that contain a shorter one must come first, since each line goes to the first label it contains
+constexpr auto data_fields = std::make_tuple(
+  field("readerEntityId: ", &rtps_data::reader_id, parse_entity_id),
+  field("writerEntityId: ", &rtps_data::writer_id, parse_entity_id),
+  field("writerSeqNumber: ", &rtps_data::writer_seq_num, parse_size),
+  parameter_pair("  PID_STATUS_INFO", &rtps_data::unregistered, &rtps_data::disposed, parse_status_info),
+  parameter("  PID_PARTICIPANT_GUID", &rtps_data::participant_guid, parse_participant_guid),
+  parameter("  PID_ENDPOINT_GUID", &rtps_data::endpoint_guid, parse_endpoint_guid),
+  parameter_pair("  PID_METATRAFFIC_UNICAST_LOCATOR (", &rtps_data::metatraffic_unicast_locator_ips, &rtps_data::metatraffic_unicast_locator_ports, parse_locator),
+  parameter_pair("  PID_METATRAFFIC_MULTICAST_LOCATOR (", &rtps_data::metatraffic_multicast_locator_ips, &rtps_data::metatraffic_multicast_locator_ports, parse_locator),
+  parameter_pair("  PID_UNICAST_LOCATOR (", &rtps_data::unicast_locator_ips, &rtps_data::unicast_locator_ports, parse_locator),
+  parameter_pair("  PID_MULTICAST_LOCATOR (", &rtps_data::multicast_locator_ips, &rtps_data::multicast_locator_ports, parse_locator),
+  parameter("  Unknown (0xb002)", &rtps_data::registered_writers, parse_registered_writer),
+  parameter("  PID_RELIABILITY", &rtps_data::endpoint_reliability, parse_reliability),
+  parameter("  PID_TOPIC_NAME", &rtps_data::topic_name, parse_topic_name),
+  parameter("  PID_TYPE_NAME", &rtps_data::type_name, parse_type_name),
+  skip<rtps_data>("  PID_DURABILITY_SERVICE"),
+  parameter("  PID_DURABILITY", &rtps_data::durability_kind, parse_durability),
+  skip<rtps_data>("  PID_OWNERSHIP_STRENGTH"),
+  parameter("  PID_OWNERSHIP", &rtps_data::ownership_kind, parse_ownership),
+  parameter("  PID_DEADLINE", &rtps_data::deadline_period, parse_deadline),
+  parameter("  PID_BUILTIN_ENDPOINT_SET", &rtps_data::builtins, parse_builtin_endpoints),
+  parameter("  PID_PARTICIPANT_LEASE_DURATION", &rtps_data::lease_duration, parse_lease_duration),
+  parameter("  PID_KEY_HASH", &rtps_data::key_hash, parse_key_hash),
+  parameter("  PID_RTI_DOMAIN_ID", &rtps_data::domain_id, parse_domain_id),
+  // Every other parameter (type objects, user data, vendor extensions) is skipped without looking at its lines
+  skip<rtps_data>("  PID_"),
+  skip<rtps_data>("  Unknown (0x")
+);
+
+constexpr auto gap_fields = std::make_tuple(
+  field("readerEntityId: ", &rtps_gap::reader_id, parse_entity_id),
+  field("writerEntityId: ", &rtps_gap::writer_id, parse_entity_id),
+  field("gapStart: ", &rtps_gap::gap_start, parse_size),
+  field("bitmapBase: ", &rtps_gap::bitmap, parse_bitmap_base),
+  field("bitmap: ", &rtps_gap::bitmap, parse_bitmap)
+);
+
+constexpr auto heartbeat_fields = std::make_tuple(
+  field("readerEntityId: ", &rtps_heartbeat::reader_id, parse_entity_id),
+  field("writerEntityId: ", &rtps_heartbeat::writer_id, parse_entity_id),
+  field("firstAvailableSeqNumber: ", &rtps_heartbeat::first_seq_num, parse_size),
+  field("lastSeqNumber: ", &rtps_heartbeat::last_seq_num, parse_size)
+);
+
+constexpr auto acknack_fields = std::make_tuple(
+  field("readerEntityId: ", &rtps_acknack::reader_id, parse_entity_id),
+  field("writerEntityId: ", &rtps_acknack::writer_id, parse_entity_id),
+  field("bitmapBase: ", &rtps_acknack::bitmap, parse_bitmap_base),
+  field("bitmap: ", &rtps_acknack::bitmap, parse_bitmap)
+);
+
+constexpr auto data_frag_fields = std::make_tuple(
+  field("readerEntityId: ", &rtps_data_frag::reader_id, parse_entity_id),
+  field("writerEntityId: ", &rtps_data_frag::writer_id, parse_entity_id),
+  field("writerSeqNumber: ", &rtps_data_frag::writer_seq_num, parse_size),
+  field("writerSN: ", &rtps_data_frag::writer_seq_num, parse_size),
+  field("fragmentStartingNum: ", &rtps_data_frag::fragment_starting_num, parse_size),
+  field("fragmentsInSubmessage: ", &rtps_data_frag::fragments_in_submessage, parse_size),
+  field("fragmentSize: ", &rtps_data_frag::fragment_size, parse_size),
+  field("sampleSize: ", &rtps_data_frag::sample_size, parse_size)
+);
+
+constexpr auto heartbeat_frag_fields = std::make_tuple(
+  field("readerEntityId: ", &rtps_heartbeat_frag::reader_id, parse_entity_id),
+  field("writerEntityId: ", &rtps_heartbeat_frag::writer_id, parse_entity_id),
+  field("writerSeqNumber: ", &rtps_heartbeat_frag::writer_seq_num, parse_size),
+  field("writerSN: ", &rtps_heartbeat_frag::writer_seq_num, parse_size),
+  field("lastFragmentNum: ", &rtps_heartbeat_frag::last_fragment_num, parse_size)
+);
+
+constexpr auto nack_frag_fields = std::make_tuple(
+  field("readerEntityId: ", &rtps_nack_frag::reader_id, parse_entity_id),
+  field("writerEntityId: ", &rtps_nack_frag::writer_id, parse_entity_id),
+  field("writerSeqNumber: ", &rtps_nack_frag::writer_seq_num, parse_size),
+  field("writerSN: ", &rtps_nack_frag::writer_seq_num, parse_size),
+  field("bitmapBase: ", &rtps_nack_frag::fragment_state, parse_bitmap_base),
+  field("bitmap: ", &rtps_nack_frag::fragment_state, parse_bitmap)
+);
+
+// Common to every reader / writer addressed submessage: flags from the line after the submessageId, both entity ids present
+template <typename T, typename Fields>
+bool parse_submessage(const frame_tree& tree, size_t sm_node, const Fields& fields, size_t sm_order, T& sm) {
+  size_t flags_node = tree.find_child(sm_node, "Flags");
+  sm.flags = flags_node == std::string::npos ? 0xFFFF : static_cast<uint16_t>(std::strtoul(tree.value(flags_node), nullptr, 16));
+  sm.sm_order = sm_order;
+  return parse_fields(fields, tree, sm_node, sm) && sm.flags != 0xFFFF && !sm.reader_id.empty() && !sm.writer_id.empty();
+}
+
+}
+
+bool process_rtps_data_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order) {
+  rtps_data data{};
+  data.lease_duration = -1.0;
+  data.deadline_period = -1.0;
+  if (!parse_submessage(tree, sm_node, data_fields, sm_order, data)) {
+    return false;
   }
 
-  for (const auto & it : rtps_submessage) {
-    size_t rpos, wpos, bpos;
-    if ((rpos = it.find("readerEntityId: 0x")) != std::string::npos) {
-      reader_id = it.substr(rpos + 18, 8);
-      //std::cout << " - reader_id = " << reader_id << std::endl;
-    } else if ((rpos = it.find("readerEntityId: ")) != std::string::npos) {
-      std::string full = it.substr(rpos + 16);
-      if ((rpos = full.find("(0x")) != std::string::npos) {
-        reader_id = full.substr(rpos + 3, 8);
-        //std::cout << " - reader_id = " << reader_id << std::endl;
-      }
-    } else if ((wpos = it.find("writerEntityId: 0x")) != std::string::npos) {
-      writer_id = it.substr(wpos + 18, 8);
-      //std::cout << " - writer_id = " << writer_id << std::endl;
-    } else if ((wpos = it.find("writerEntityId: ")) != std::string::npos) {
-      std::string full = it.substr(wpos + 16);
-      if ((wpos = full.find("(0x")) != std::string::npos) {
-        writer_id = full.substr(wpos + 3, 8);
-        //std::cout << " - writer_id = " << writer_id << std::endl;
-      }
-    } else if ((bpos = it.find("bitmapBase: ")) != std::string::npos) {
-      std::string full = it.substr(bpos + 12);
-      std::stringstream ss(full);
-      ss >> bitmap_base;
-    } else if ((bpos = it.find("bitmap: ")) != std::string::npos) {
-      bitmap = it.substr(bpos + 8);
+  // Disposes and unregisters usually identify the instance by key hash alone
+  if ((data.unregistered || data.disposed) && data.key_hash.length() == 32) {
+    if (data.writer_id == "000100c2" && data.participant_guid.empty()) {
+      data.participant_guid = data.key_hash;
+    } else if ((data.writer_id == "000003c2" || data.writer_id == "000004c2") && data.endpoint_guid.empty()) {
+      data.endpoint_guid = data.key_hash;
     }
   }
 
-  if (flags != 0xFFFF && !reader_id.empty() && !writer_id.empty()) {
-    rtps_acknack acknack;
-    acknack.flags = flags;
-    acknack.reader_id = reader_id;
-    acknack.writer_id = writer_id;
-    acknack.bitmap_base = bitmap_base;
-    acknack.bitmap = bitmap;
-    acknack.sm_order = sm_order;
-    frame.acknack_vec.push_back(acknack);
-    result = true;
+  // Participant / endpoint details only count when they come with a well-formed guid
+  if (data.participant_guid.length() != 32) {
+    data.participant_guid.clear();
+    data.metatraffic_unicast_locator_ips.clear();
+    data.metatraffic_unicast_locator_ports.clear();
+    data.metatraffic_multicast_locator_ips.clear();
+    data.metatraffic_multicast_locator_ports.clear();
+    data.builtins = 0;
+  }
+  if (data.endpoint_guid.length() != 32) {
+    data.endpoint_guid.clear();
+    data.unicast_locator_ips.clear();
+    data.unicast_locator_ports.clear();
+    data.multicast_locator_ips.clear();
+    data.multicast_locator_ports.clear();
+    data.registered_writers.clear();
+    data.endpoint_reliability = false;
+    data.topic_name.clear();
+    data.type_name.clear();
+    data.durability_kind = 0;
+    data.ownership_kind = 0;
+    data.deadline_period = -1.0;
+  }
+  frame.domain_id = data.domain_id;
+  frame.data_vec.push_back(std::move(data));
+  return true;
+}
+
+bool process_rtps_gap_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order) {
+  rtps_gap gap{};
+  if (!parse_submessage(tree, sm_node, gap_fields, sm_order, gap)) {
+    return false;
   }
-  return result;
+  frame.gap_vec.push_back(std::move(gap));
+  return true;
 }
 
-bool process_rtps_submessage(const string_vec& rtps_submessage, rtps_frame& frame, size_t sm_order)
+bool process_rtps_heartbeat_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order) {
+  rtps_heartbeat heartbeat{};
+  if (!parse_submessage(tree, sm_node, heartbeat_fields, sm_order, heartbeat)) {
+    return false;
+  }
+  frame.heartbeat_vec.push_back(std::move(heartbeat));
+  return true;
+}
+
+bool process_rtps_acknack_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order) {
+  rtps_acknack acknack{};
+  if (!parse_submessage(tree, sm_node, acknack_fields, sm_order, acknack)) {
+    return false;
+  }
+  frame.acknack_vec.push_back(std::move(acknack));
+  return true;
+}
+
+bool process_rtps_data_frag_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order) {
+  rtps_data_frag data_frag{};
+  if (!parse_submessage(tree, sm_node, data_frag_fields, sm_order, data_frag) || data_frag.fragment_starting_num == 0 || data_frag.fragment_size == 0) {
+    return false;
+  }
+  frame.data_frag_vec.push_back(std::move(data_frag));
+  return true;
+}
+
+bool process_rtps_heartbeat_frag_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order) {
+  rtps_heartbeat_frag heartbeat_frag{};
+  if (!parse_submessage(tree, sm_node, heartbeat_frag_fields, sm_order, heartbeat_frag)) {
+    return false;
+  }
+  frame.heartbeat_frag_vec.push_back(std::move(heartbeat_frag));
+  return true;
+}
+
+bool process_rtps_nack_frag_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order) {
+  rtps_nack_frag nack_frag{};
+  if (!parse_submessage(tree, sm_node, nack_frag_fields, sm_order, nack_frag)) {
+    return false;
+  }
+  frame.nack_frag_vec.push_back(std::move(nack_frag));
+  return true;
+}
+
+bool process_rtps_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order)
 {
   bool result = false;
-  if (!rtps_submessage.empty()) {
-    size_t spos;
-    if ((spos = rtps_submessage.front().find("submessageId: ")) != std::string::npos) {
-      std::string sm_type = rtps_submessage.front().substr(spos + 14);
-      sm_type = sm_type.substr(0, sm_type.find(' '));
-      //std::cout << sm_type << std::endl;
-      if (sm_type == "INFO_DST") {
-        result = process_rtps_info_dst_submessage(rtps_submessage, frame, sm_order);
-      } else if (sm_type == "DATA") {
-        result = process_rtps_data_submessage(rtps_submessage, frame, sm_order);
-      } else if (sm_type == "GAP") {
-        result = process_rtps_gap_submessage(rtps_submessage, frame, sm_order);
-      } else if (sm_type == "HEARTBEAT") {
-        result = process_rtps_heartbeat_submessage(rtps_submessage, frame, sm_order);
-      } else if (sm_type == "ACKNACK") {
-        result = process_rtps_acknack_submessage(rtps_submessage, frame, sm_order);
-      } else {
-        result = true;
-      }
+  size_t spos;
+  if ((spos = tree.line(sm_node).find("submessageId: ")) != std::string::npos) {
+    std::string sm_type = tree.line(sm_node).substr(spos + 14);
+    sm_type = sm_type.substr(0, sm_type.find(' '));
+    //std::cout << sm_type << std::endl;
+    if (sm_type == "INFO_DST") {
+      result = process_rtps_info_dst_submessage(tree, sm_node, frame, sm_order);
+    } else if (sm_type == "DATA") {
+      result = process_rtps_data_submessage(tree, sm_node, frame, sm_order);
+    } else if (sm_type == "GAP") {
+      result = process_rtps_gap_submessage(tree, sm_node, frame, sm_order);
+    } else if (sm_type == "HEARTBEAT") {
+      result = process_rtps_heartbeat_submessage(tree, sm_node, frame, sm_order);
+    } else if (sm_type == "ACKNACK") {
+      result = process_rtps_acknack_submessage(tree, sm_node, frame, sm_order);
+    } else if (sm_type == "DATA_FRAG") {
+      result = process_rtps_data_frag_submessage(tree, sm_node, frame, sm_order);
+    } else if (sm_type == "HEARTBEAT_FRAG") {
+      result = process_rtps_heartbeat_frag_submessage(tree, sm_node, frame, sm_order);
+    } else if (sm_type == "NACK_FRAG") {
+      result = process_rtps_nack_frag_submessage(tree, sm_node, frame, sm_order);
+    } else {
+      result = true;
     }
   }
   return result;
 }
 
-bool process_rtps_submessages(const std::vector<string_vec>& rtps_submessages, rtps_frame& frame) {
+bool process_rtps_submessages(const frame_tree& tree, const std::vector<size_t>& sm_nodes, rtps_frame& frame) {
   bool result = true;
   size_t sm_order = 0;
-  for (auto it = rtps_submessages.begin(); result && it != rtps_submessages.end(); ++it) {
-    result &= process_rtps_submessage(*it, frame, sm_order++);
+  for (auto it = sm_nodes.begin(); result && it != sm_nodes.end(); ++it) {
+    result &= process_rtps_submessage(tree, *it, frame, sm_order++);
   }
   return result;
 }
 
-void process_frame(const string_vec& tshark_frame_data, std::map<size_t, rtps_frame>& frames, ip_frag_map& ifm) {
-
-  string_vec frame_header;
-  string_vec eth_header;
-  string_vec ip_header;
-  string_vec udp_header;
-  string_vec rtps_header;
-  std::vector<string_vec> rtps_submessages;
-
-  for (const auto & it : tshark_frame_data) {
-    if (eth_header.empty() && it.substr(0, 8) != "Ethernet" && it != "Linux cooked capture") {
-      frame_header.push_back(it);
-    } else if (ip_header.empty() && it.substr(0, 17) != "Internet Protocol") {
-      eth_header.push_back(it);
-    } else if (udp_header.empty() && it.substr(0, 22) != "User Datagram Protocol") {
-      ip_header.push_back(it);
-    } else if (rtps_header.empty() && it.substr(0, 41) != "Real-Time Publish-Subscribe Wire Protocol") {
-      udp_header.push_back(it);
-    } else if (rtps_submessages.empty() && it.find("submessageId:") == std::string::npos) {
-      rtps_header.push_back(it);
-    } else if (it.find("submessageId:") != std::string::npos) {
-      rtps_submessages.emplace_back();
-      rtps_submessages.back().push_back(it);
-    } else {
-      rtps_submessages.back().push_back(it);
-    }
-  }
+bool process_frame(const string_vec& tshark_frame_data, std::map<size_t, rtps_frame>& frames, ip_fragment_tracker& ift, const frame_filter& filter) {
+  frame_tree tree;
+  build_frame_tree(tshark_frame_data, tree);
 
-  /*
-  // Some debugging output for section sizes
-  std::cout << frame_header.size() << " " << eth_header.size() << " " << ip_header.size() << " " << udp_header.size() << " " << rtps_header.size() << std::flush;
-  if (rtps_submessages.size()) {
-    std::cout << " (" << std::flush;
-    for (auto it = rtps_submessages.begin(); it != rtps_submessages.end(); ++it) {
-      if (it != rtps_submessages.begin()) {
-        std::cout << ", " << std::flush;
+  // Each layer runs from the top-level line carrying its marker up to the next layer's marker; a missing marker leaves
+  // the rest of the frame in the layer before it
+  size_t line_count = tshark_frame_data.size();
+  auto next_marker = [&tree, line_count](size_t from, const char* marker) {
+    while (from < line_count && !tree.label_starts_with(from, marker)) {
+      from = tree.end(from);
+    }
+    return from;
+  };
+  size_t eth_begin = next_marker(0, "Ethernet");
+  size_t cooked_begin = next_marker(0, "Linux cooked capture");
+  eth_begin = std::min(eth_begin, cooked_begin);
+  size_t ip_begin = next_marker(eth_begin, "Internet Protocol");
+  size_t udp_begin = next_marker(ip_begin, "User Datagram Protocol");
+  size_t rtps_begin = next_marker(udp_begin, "Real-Time Publish-Subscribe Wire Protocol");
+
+  // Submessages are the RTPS layer's children, and everything before the first of them is the RTPS header
+  std::vector<size_t> rtps_submessages;
+  size_t rtps_header_end = line_count;
+  if (rtps_begin < line_count) {
+    rtps_header_end = tree.end(rtps_begin);
+    for (size_t i = rtps_begin + 1; i < tree.end(rtps_begin); i = tree.end(i)) {
+      if (tree.label_starts_with(i, "submessageId")) {
+        rtps_header_end = std::min(rtps_header_end, i);
+        rtps_submessages.push_back(i);
       }
-      std::cout << it->size() << std::flush;
     }
-    std::cout << ")" << std::flush;
   }
-  std::cout << std::endl;
-  */
+
+  line_range frame_header = tree.lines_between(0, eth_begin);
+  line_range eth_header = tree.lines_between(eth_begin, ip_begin);
+  line_range ip_header = tree.lines_between(ip_begin, udp_begin);
+  line_range udp_header = tree.lines_between(udp_begin, rtps_begin);
+  line_range rtps_header = tree.lines_between(rtps_begin, rtps_header_end);
 
   rtps_frame frame;
   frame.frame_no = 0;
-  if (process_frame_header(frame_header, frame) &&
-      process_eth_header(eth_header, frame) &&
-      process_ip_header(ip_header, frame, ifm) &&
+  if (!process_frame_header(frame_header, frame)) {
+    return true;
+  }
+  if (!filter_accepts_time(filter, frame)) {
+    return false;
+  }
+  if (process_eth_header(eth_header, frame) &&
+      process_ip_header(ip_header, frame, ift) &&
       process_udp_header(udp_header, frame))
   {
-    if (process_rtps_header(rtps_header, frame) &&
-        process_rtps_submessages(rtps_submessages, frame))
-    {
-      //std::cout << "successfully processed frame " << frame.frame_no << std::endl;
-      frames[frame.frame_no] = frame;
+    if (!filter_accepts_port(filter, frame)) {
+      return false;
     }
-    else
-    {
-      std::cout << "error processing frame " << frame.frame_no << std::endl;
+    if (process_rtps_header(rtps_header, frame)) {
+      if (!filter_accepts_guids(filter, frame, tree, rtps_submessages)) {
+        return false;
+      }
+      if (process_rtps_submessages(tree, rtps_submessages, frame)) {
+        //std::cout << "successfully processed frame " << frame.frame_no << std::endl;
+        frames[frame.frame_no] = frame;
+        return true;
+      }
     }
+    std::cout << "error processing frame " << frame.frame_no << std::endl;
   }
   else
   {
     //std::cout << "encountered issue, skipping frame" << frame.frame_no << std::endl;
   }
+  return true;
 }
 
-void process_frame_data(const tshark_frame_map& fd, std::map<size_t, rtps_frame>& frames, ip_frag_map& ifm) {
+size_t process_frame_data(const tshark_frame_map& fd, std::map<size_t, rtps_frame>& frames, ip_fragment_tracker& ift, const frame_filter& filter) {
+  size_t filtered = 0;
   for (const auto & it : fd) {
-    process_frame(it.second, frames, ifm);
+    if (!process_frame(it.second, frames, ift, filter)) {
+      ++filtered;
+    }
   }
+  return filtered;
 }
 
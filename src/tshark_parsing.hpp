@@ -1,24 +1,32 @@
 #pragma once
 
 #include "common_types.hpp"
+#include "frame_filter.hpp"
+#include "frame_tree.hpp"
 #include "frames.hpp"
+#include "ip_fragments.hpp"
 
 #include <map>
 
 using tshark_frame_map = std::map<size_t, string_vec>;
 
-bool process_frame_header(const string_vec& frame_header, rtps_frame& frame);
-bool process_eth_header(const string_vec& eth_header, rtps_frame& frame);
-bool process_ip_header(const string_vec& ip_header, rtps_frame& frame, ip_frag_map& ifm);
-bool process_udp_header(const string_vec& udp_header, rtps_frame& frame);
-bool process_rtps_header(const string_vec& rtps_header, rtps_frame& frame);
-bool process_rtps_submessages(const std::vector<string_vec>& rtps_submessages, rtps_frame& frame);
-bool process_rtps_submessage(const string_vec& rtps_submessage, rtps_frame& frame, size_t sm_order);
-bool process_rtps_info_dst_submessage(const string_vec& rtps_submessage, rtps_frame& frame, size_t sm_order);
-bool process_rtps_data_submessage(const string_vec& rtps_submessage, rtps_frame& frame, size_t sm_order);
-bool process_rtps_gap_submessage(const string_vec& rtps_submessage, rtps_frame& frame, size_t sm_order);
-bool process_rtps_heartbeat_submessage(const string_vec& rtps_submessage, rtps_frame& frame, size_t sm_order);
-bool process_rtps_acknack_submessage(const string_vec& rtps_submessage, rtps_frame& frame, size_t sm_order);
-void process_frame(const string_vec& tshark_frame_data, rtps_frame_map& frames, ip_frag_map& ifm);
-void process_frame_data(const tshark_frame_map& fd, rtps_frame_map& frames, ip_frag_map& ifm);
+bool process_frame_header(const line_range& frame_header, rtps_frame& frame);
+bool process_eth_header(const line_range& eth_header, rtps_frame& frame);
+bool process_ip_header(const line_range& ip_header, rtps_frame& frame, ip_fragment_tracker& ift);
+bool process_udp_header(const line_range& udp_header, rtps_frame& frame);
+bool process_rtps_header(const line_range& rtps_header, rtps_frame& frame);
+bool process_rtps_submessages(const frame_tree& tree, const std::vector<size_t>& sm_nodes, rtps_frame& frame);
+bool process_rtps_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order);
+bool process_rtps_info_dst_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order);
+bool process_rtps_data_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order);
+bool process_rtps_gap_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order);
+bool process_rtps_heartbeat_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order);
+bool process_rtps_acknack_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order);
+bool process_rtps_data_frag_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order);
+bool process_rtps_heartbeat_frag_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order);
+bool process_rtps_nack_frag_submessage(const frame_tree& tree, size_t sm_node, rtps_frame& frame, size_t sm_order);
+// Returns false when the frame was rejected by the filter (frames that simply aren't RTPS still return true)
+bool process_frame(const string_vec& tshark_frame_data, rtps_frame_map& frames, ip_fragment_tracker& ift, const frame_filter& filter);
+// Returns the number of frames rejected by the filter
+size_t process_frame_data(const tshark_frame_map& fd, rtps_frame_map& frames, ip_fragment_tracker& ift, const frame_filter& filter);
 
@@ -0,0 +1,227 @@
+#include "undiscovered.hpp"
+
+#include "utils.hpp"
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+const size_t guid_prefix_length = 24;
+
+struct participant_reach {
+  undiscovered_cause cause{UC_NO_SPDP};
+  std::vector<size_t> frames;
+};
+
+// Maps each metatraffic locator ip to the participants (and ports, if known) whose SPDP readers listen on it
+using locator_index = std::unordered_map<std::string, std::vector<std::pair<std::string, std::string>>>;
+
+locator_index build_locator_index(const endpoint_map& em) {
+  locator_index index;
+  for (const auto & it : em) {
+    const std::string& guid = it.first;
+    if (guid.length() != 32 || guid.compare(guid_prefix_length, std::string::npos, "000100c7") != 0) {
+      continue;
+    }
+    for (const auto & nit : it.second.dst_net_map) {
+      index[nit.first].emplace_back(guid.substr(0, guid_prefix_length), nit.second.port);
+    }
+  }
+  return index;
+}
+
+participant_reach check_participant(const endpoint_map& em, const locator_index& index, const std::string& prefix) {
+  participant_reach result;
+  auto pit = em.find(prefix + "000100c2");
+  if (pit == em.end() || pit->second.spdp_announcements.empty()) {
+    return result;
+  }
+  const std::vector<data_info_pair>& spdp = pit->second.spdp_announcements;
+  for (const auto & d : spdp) {
+    auto lit = index.find(d.first->dst_ip);
+    if (lit == index.end()) {
+      continue;
+    }
+    for (const auto & listener : lit->second) {
+      if (listener.first != prefix && (listener.second.empty() || listener.second == d.first->dst_port)) {
+        result.cause = UC_SEDP_UNACKED; // provisional: SPDP got through, the endpoint checks decide the rest
+        result.frames.push_back(d.first->frame_no);
+        return result;
+      }
+    }
+  }
+  result.cause = UC_SPDP_UNREACHED;
+  result.frames.push_back(spdp.front().first->frame_no);
+  if (spdp.size() > 1) {
+    result.frames.push_back(spdp.back().first->frame_no);
+  }
+  return result;
+}
+
+// Acknacks received by one builtin SEDP writer (from every remote reader), sorted by frame, with a sparse table of the
+// largest bitmap base over each power-of-two run of them
+struct sedp_ack_index {
+  std::vector<size_t> frames;
+  std::vector<std::vector<size_t>> max_base; // max_base[k][i]: largest base among acknacks i .. i + 2^k - 1
+
+  explicit sedp_ack_index(const std::map<std::string, conversation_info>& readers) {
+    std::vector<std::pair<size_t, size_t>> acks;
+    for (const auto & rit : readers) {
+      for (const auto & an : rit.second.acknacks) {
+        acks.emplace_back(an.first->frame_no, an.second->bitmap.base);
+      }
+    }
+    std::sort(acks.begin(), acks.end());
+    frames.reserve(acks.size());
+    max_base.emplace_back();
+    max_base[0].reserve(acks.size());
+    for (const auto & ack : acks) {
+      frames.push_back(ack.first);
+      max_base[0].push_back(ack.second);
+    }
+    for (size_t k = 1; (size_t(1) << k) <= frames.size(); ++k) {
+      const std::vector<size_t>& prev = max_base[k - 1];
+      size_t half = size_t(1) << (k - 1);
+      std::vector<size_t> level(frames.size() - 2 * half + 1);
+      for (size_t i = 0; i < level.size(); ++i) {
+        level[i] = std::max(prev[i], prev[i + half]);
+      }
+      max_base.push_back(std::move(level));
+    }
+  }
+
+  size_t range_max(size_t first, size_t last) const {
+    size_t k = 0;
+    while ((size_t(2) << k) <= last - first + 1) {
+      ++k;
+    }
+    return std::max(max_base[k][first], max_base[k][last + 1 - (size_t(1) << k)]);
+  }
+
+  // Frame of the first acknack at or after frame_no acknowledging seq_num (its base is past it), or 0 if there is none
+  size_t first_ack(size_t frame_no, size_t seq_num) const {
+    size_t lo = static_cast<size_t>(std::lower_bound(frames.begin(), frames.end(), frame_no) - frames.begin());
+    if (lo == frames.size() || range_max(lo, frames.size() - 1) <= seq_num) {
+      return 0;
+    }
+    size_t first = lo;
+    size_t hi = frames.size() - 1;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      if (range_max(first, mid) > seq_num) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return frames[lo];
+  }
+};
+
+using sedp_ack_map = std::unordered_map<std::string, sedp_ack_index>;
+
+// Returns the frame of the first acknack from a remote builtin reader covering one of the endpoint's own SEDP announcements
+// (0 if there is none), collecting the announcement frames along the way; each builtin SEDP writer is indexed on first use
+size_t find_sedp_ack(const conversation_map& cm, sedp_ack_map& acks, const endpoint_info& info, std::vector<size_t>& announcement_frames) {
+  size_t ack_frame = 0;
+  for (const auto & d : info.sedp_announcements) {
+    // Reader announcements also list the writers registered with them; those entries announce someone else
+    if (d.second->endpoint_guid != info.guid) {
+      continue;
+    }
+    announcement_frames.push_back(d.first->frame_no);
+    const std::string writer_guid = d.first->guid_prefix + d.second->writer_id;
+    auto ait = acks.find(writer_guid);
+    if (ait == acks.end()) {
+      auto cit = cm.find(writer_guid);
+      if (cit == cm.end()) {
+        continue;
+      }
+      ait = acks.emplace(writer_guid, sedp_ack_index(cit->second)).first;
+    }
+    size_t frame_no = ait->second.first_ack(d.first->frame_no, d.second->writer_seq_num);
+    if (frame_no != 0 && (ack_frame == 0 || frame_no < ack_frame)) {
+      ack_frame = frame_no;
+    }
+  }
+  return ack_frame;
+}
+
+}
+
+const char* undiscovered_cause_name(undiscovered_cause cause) {
+  switch (cause) {
+    case UC_NO_SPDP:
+      return "no SPDP from its participant";
+    case UC_SPDP_UNREACHED:
+      return "SPDP not reaching any peer's locators";
+    case UC_SEDP_UNACKED:
+      return "SEDP never acknowledged";
+    case UC_NO_COMPATIBLE_PEER:
+      return "no compatible remote endpoint seen";
+    case UC_COUNT:
+    default:
+      return "unknown";
+  }
+}
+
+void gather_undiscovered_info(const endpoint_map& em, const conversation_map& cm, const std::set<std::string>& guids, undiscovered_info& ui) {
+  const locator_index index = build_locator_index(em);
+  std::unordered_map<std::string, participant_reach> participants;
+  sedp_ack_map acks;
+  for (const auto & guid : guids) {
+    undiscovered_endpoint ue;
+    ue.guid = guid;
+    const std::string prefix = guid.substr(0, guid_prefix_length);
+    auto pit = participants.find(prefix);
+    if (pit == participants.end()) {
+      pit = participants.emplace(prefix, check_participant(em, index, prefix)).first;
+    }
+    const participant_reach& reach = pit->second;
+    ue.cause = reach.cause;
+    ue.frames = reach.frames;
+
+    auto eit = em.find(guid);
+    if (ue.cause == UC_NO_SPDP && eit != em.end()) {
+      ue.frames.push_back(eit->second.first_evidence_frame);
+    } else if (ue.cause == UC_SEDP_UNACKED) {
+      // Builtin endpoints are announced by SPDP itself, so only user endpoints go through SEDP
+      ue.cause = UC_NO_COMPATIBLE_PEER;
+      if (eit != em.end() && !is_guid_builtin(guid)) {
+        std::vector<size_t> announcement_frames;
+        size_t ack_frame = find_sedp_ack(cm, acks, eit->second, announcement_frames);
+        if (ack_frame == 0) {
+          ue.cause = UC_SEDP_UNACKED;
+          ue.frames = announcement_frames;
+        } else {
+          ue.frames.assign(1, announcement_frames.front());
+          ue.frames.push_back(ack_frame);
+        }
+      }
+    }
+    ++ui.cause_counts[ue.cause];
+    ui.endpoints.push_back(std::move(ue));
+  }
+}
+
+void print_undiscovered_info(std::ostream& os, const undiscovered_info& ui) {
+  for (const auto & ue : ui.endpoints) {
+    os << ue.guid << " - " << undiscovered_cause_name(ue.cause);
+    if (!ue.frames.empty()) {
+      os << " (frames";
+      for (size_t frame_no : ue.frames) {
+        os << ' ' << frame_no;
+      }
+      os << ")";
+    }
+    os << '\n';
+  }
+  os << "Undiscovered endpoints by cause:" << '\n';
+  for (size_t c = 0; c < UC_COUNT; ++c) {
+    os << " - " << undiscovered_cause_name(static_cast<undiscovered_cause>(c)) << ": " << ui.cause_counts[c] << '\n';
+  }
+  os << std::flush;
+}
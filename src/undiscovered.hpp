@@ -0,0 +1,37 @@
+#pragma once
+
+#include "conversation_info.hpp"
+#include "endpoint_info.hpp"
+
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+// Stage at which matching stalled for an endpoint without any conversation, earliest stage first
+enum undiscovered_cause : uint8_t {
+  UC_NO_SPDP,            // its participant was never announced via SPDP
+  UC_SPDP_UNREACHED,     // no SPDP announcement was sent to a locator any other participant listens on
+  UC_SEDP_UNACKED,       // its SEDP announcement was never sent or never acknowledged by a remote builtin reader
+  UC_NO_COMPATIBLE_PEER, // discovery completed but no remote endpoint matched it
+  UC_COUNT
+};
+
+const char* undiscovered_cause_name(undiscovered_cause cause);
+
+struct undiscovered_endpoint {
+  std::string guid;
+  undiscovered_cause cause{UC_NO_SPDP};
+  std::vector<size_t> frames; // supporting evidence, e.g. the SPDP or SEDP announcements that went unanswered
+};
+
+struct undiscovered_info {
+  std::vector<undiscovered_endpoint> endpoints; // in guid order
+  size_t cause_counts[UC_COUNT]{};
+};
+
+// Per-participant checks (SPDP presence and reach) are computed once and shared by all of the participant's endpoints;
+// SPDP reach is decided through an index of the locators each participant's SPDP reader listens on, and SEDP
+// acknowledgement by binary search over each builtin SEDP writer's acknacks, sorted by frame
+void gather_undiscovered_info(const endpoint_map& em, const conversation_map& cm, const std::set<std::string>& guids, undiscovered_info& ui);
+void print_undiscovered_info(std::ostream& os, const undiscovered_info& ui);
@@ -23,19 +23,10 @@ bool is_ip_multicast(const std::string& ip) {
 }
 
 bool is_id_builtin(const std::string& id) {
-  static std::set<std::string> id_set;
-  if (id_set.empty()) {
-    id_set.insert("000002c2");
-    id_set.insert("000002c7");
-    id_set.insert("000003c2");
-    id_set.insert("000003c7");
-    id_set.insert("000004c2");
-    id_set.insert("000004c7");
-    id_set.insert("000100c2");
-    id_set.insert("000100c7");
-    id_set.insert("000200c2");
-    id_set.insert("000200c7");
-  }
+  // Initialized once, so captures can be analyzed on several threads at a time
+  static const std::set<std::string> id_set = {
+    "000002c2", "000002c7", "000003c2", "000003c7", "000004c2", "000004c7", "000100c2", "000100c7", "000200c2", "000200c7"
+  };
   return id_set.find(id) != id_set.end();
 }
 